@@ -7,6 +7,7 @@
 
 extern "C" {
 #include "pico_vm.h"
+#include "pico_audio_out.h"
 #include "pico_config.h"
 }
 
@@ -38,6 +39,9 @@ private:
     lv_obj_t* cartList = nullptr;
     lv_obj_t* parentWidget = nullptr;
 
+    // Audio output (ring + sink thread), running while the app is shown
+    pico_audio_out_t audioOut{};
+
     // Canvas buffer — RGB565 (2 bytes per pixel)
     uint16_t cbuf[CANVAS_W * CANVAS_H]{};
 
@@ -53,6 +57,7 @@ private:
     void returnToMenu();
     void startCartFromPath(const char* path);
     void buildCartList(lv_obj_t* list);
+    void startAudio();
 
     // Static callbacks
     static void onCartSelectClicked(lv_event_t* e);
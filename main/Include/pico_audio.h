@@ -1,5 +1,5 @@
 // pico_audio.h
-// PICO-8 audio subsystem (simplified, no reverb)
+// PICO-8 audio subsystem
 
 #ifndef PICO_AUDIO_H
 #define PICO_AUDIO_H
@@ -10,6 +10,8 @@
 // Audio Constants
 #define PICO_SAMPLE_RATE    22050
 #define PICO_NOTES_PER_SFX  32
+#define PICO_INSTRUMENTS    8       // Custom instruments are SFX 0-7
+#define PICO_AUDIO_BLOCK    256     // Samples mixed per pass
 
 // Waveform types
 typedef enum {
@@ -35,37 +37,138 @@ typedef enum {
     PICO_FX_ARPSLOW     = 7,
 } pico_effect_t;
 
-// Channel State (~50 bytes per channel)
+// Channel State (48 bytes; each channel also has a sub-voice)
 typedef struct {
     int8_t sfx_index;           // -1 if not playing
     uint8_t note_index;
-    uint32_t sample_counter;
-    uint32_t samples_per_tick;
+    uint8_t note_end;           // Stop (or loop) before this note
+    bool music;                 // Started by the music sequencer
+    uint32_t sample_counter;    // Samples into the current note
+    uint32_t samples_per_tick;  // Samples per note (speed ticks)
+    uint32_t sfx_samples;       // Samples since the sfx started (vibrato, arps)
     uint32_t phase;
-    uint32_t phase_inc;
+    uint32_t phase_inc;         // Note pitch before effects
+    uint32_t prev_phase_inc;    // Previous note, for slides
+    uint8_t prev_volume;
     uint8_t waveform;
     uint8_t volume;
     uint8_t effect;
+    bool custom;                // Note plays instrument 'waveform' as a sub-voice
+    bool instrument;            // This is a sub-voice, notes come from the cache
     fix32_t frequency;
     fix32_t base_frequency;
-    fix32_t effect_value;
     uint16_t noise_lfsr;
 } pico_channel_t;
 
+// Decoded Note
+// The synth reads notes only through this; waveform carries the custom
+// instrument flag so the struct stays at 8 bytes
+#define PICO_NOTE_CUSTOM    0x08    // waveform & 7 is an instrument (SFX 0-7)
+
+typedef struct {
+    uint32_t phase_inc;         // From key, at the synth rate
+    uint8_t key;
+    uint8_t waveform;           // 0-7, | PICO_NOTE_CUSTOM
+    uint8_t volume;
+    uint8_t effect;
+} pico_note_decoded_t;
+
+// SFX Cache (decoded on first play, dropped when its SFX is written)
+typedef struct {
+    pico_note_decoded_t notes[PICO_NOTES_PER_SFX];
+    uint32_t samples_per_tick;
+    bool valid;
+} pico_sfx_cache_t;
+
+// Channel Filters
+// Decoded from the 0x5F41 (reverb), 0x5F42 (distort) and 0x5F43 (lowpass)
+// channel masks whenever one of the registers changes
+typedef struct {
+    bool reverb;                // Sent to the shared reverb
+    bool distort;               // Waveshaper (pico_distort_curve)
+    bool lowpass;               // One-pole lowpass
+    int32_t lp_coef;            // 16.16, 0 when off
+    int32_t lp_state;
+} pico_channel_filter_t;
+
+#if PICO_ENABLE_REVERB
+// Reverb (~2KB)
+// Schroeder network of two damped combs and two allpasses, run at half
+// the synth rate on int16 lines so ~70ms of delay fits in 1.5KB
+#define PICO_REVERB_COMB1   293
+#define PICO_REVERB_COMB2   337
+#define PICO_REVERB_AP1     97
+#define PICO_REVERB_AP2     41
+
+typedef struct {
+    int16_t comb1[PICO_REVERB_COMB1];
+    int16_t comb2[PICO_REVERB_COMB2];
+    int16_t ap1[PICO_REVERB_AP1];
+    int16_t ap2[PICO_REVERB_AP2];
+    uint16_t pos_c1, pos_c2, pos_a1, pos_a2;
+    int32_t damp1, damp2;       // Comb feedback lowpass state
+    int16_t send[PICO_AUDIO_BLOCK];  // Sum of reverb channels this block
+    int32_t acc;                // Pending full-rate input sample
+    int32_t wet, prev_wet;
+    bool half;                  // Odd full-rate sample of a pair
+} pico_reverb_t;
+#endif
+
+// PCM Stream
+// Unsigned 8-bit samples from serial(0x808) at PICO_SAMPLE_RATE / 4
+#define PICO_PCM_RATE_DIV   4       // 5512.5Hz
+
+typedef struct {
+    uint8_t data[PICO_AUDIO_PCM_STREAM_SIZE];
+    uint32_t head, tail;        // Free-running sample counts
+    int32_t prev, next;         // Interpolation end points, mix scale
+    uint8_t phase;              // Output samples into the current one
+} pico_pcm_stream_t;
+
 // Music State
+// The sequencer runs on pico_audio_fill's sample clock: samples_left counts
+// down to the exact sample where the pattern's timing channel ends.
 typedef struct {
     int8_t pattern_index;       // -1 if stopped
-    uint8_t tick;
-    bool loop_enabled;
+    uint8_t channel_mask;       // Channels reserved from sfx() auto-select
+    uint32_t pattern_samples;   // Length of the current pattern
+    uint32_t samples_left;      // Until the next pattern transition
+    int32_t gain;               // 16.16, ramps during fades
+    int32_t fade_from;          // Gain when the fade started
+    int32_t fade_to;            // Gain it ends on: 0 fades out
+    uint32_t fade_total;        // Fade length in samples
+    uint32_t fade_left;         // Samples until the fade completes
+    uint32_t tick_samples;      // Note length of the timing channel
+    uint16_t patterns_played;   // Since music() last started a song
 } pico_music_state_t;
 
+// Sequencer Snapshot
+// Published by the mixer once per block for stat(46-57). A reader copies
+// it between two reads of an even sequence count instead of locking.
+typedef struct {
+    int8_t sfx[PICO_CHANNELS];  // -1 when idle
+    int8_t note[PICO_CHANNELS]; // -1 when idle
+    int8_t pattern;             // -1 when music is stopped
+    uint16_t patterns_played;
+    uint16_t ticks;             // Notes played in the current pattern
+} pico_audio_status_t;
+
 // Audio Context
 typedef struct {
     pico_ram_t* ram;
     pico_channel_t channels[PICO_CHANNELS];
+    pico_channel_t voices[PICO_CHANNELS];   // Instrument sub-voice per channel
+    pico_sfx_cache_t sfx_cache[PICO_SFX_COUNT];
     pico_music_state_t music;
-    int16_t buffer[PICO_AUDIO_BUFFER_SIZE];
-    uint16_t buffer_pos;
+    pico_channel_filter_t filters[PICO_CHANNELS];
+    uint8_t filter_regs[3];     // 0x5F41-0x5F43 the filters were built from
+    int32_t filter_buf[PICO_AUDIO_BLOCK];   // One filtered channel at a time
+#if PICO_ENABLE_REVERB
+    pico_reverb_t reverb;
+#endif
+    pico_pcm_stream_t pcm;
+    pico_audio_status_t status;
+    uint32_t status_seq;        // Odd while the mixer is writing status
     uint8_t master_volume;
 } pico_audio_t;
 
@@ -81,11 +184,32 @@ void pico_sfx(pico_audio_t* audio, int8_t n, int8_t channel, uint8_t offset, uin
 
 // Music Playback
 // n: Pattern number (0-63), -1 to stop
+// fade_ms: fade in (or out when stopping) over this many milliseconds
+// channel_mask: channels reserved for music; sfx(n, -1) will not use them
 void pico_music(pico_audio_t* audio, int8_t n, uint16_t fade_ms, uint8_t channel_mask);
 
+// Latest sequencer snapshot; never blocks the mixer
+void pico_audio_get_status(const pico_audio_t* audio, pico_audio_status_t* status);
+
+// PCM Stream
+// Queues up to len samples, returns how many fit
+uint32_t pico_audio_pcm_write(pico_audio_t* audio, const uint8_t* data, uint32_t len);
+uint32_t pico_audio_pcm_queued(const pico_audio_t* audio);
+
+// Drop decoded SFX derived from a written RAM range
+void pico_audio_mem_written(pico_audio_t* audio, uint16_t addr, uint16_t len);
+
 // Audio Processing
+// Output formats pico_audio_fill_format can write directly
+typedef enum {
+    PICO_PCM_S16_MONO,          // Signed 16-bit
+    PICO_PCM_S16_STEREO,        // Signed 16-bit, mono duplicated to L/R
+    PICO_PCM_U8,                // Unsigned 8-bit, for DAC/PWM outputs
+} pico_pcm_format_t;
+
 void pico_audio_fill(pico_audio_t* audio, int16_t* out, uint16_t samples);
-void pico_audio_update(pico_audio_t* audio);
+void pico_audio_fill_format(pico_audio_t* audio, void* out, uint16_t samples,
+                            pico_pcm_format_t format);
 
 // Utility
 fix32_t pico_note_to_freq(uint8_t note);
@@ -0,0 +1,108 @@
+// pico_audio_out.h
+// PCM output: lock-free ring between the emulator and an output thread
+
+#ifndef PICO_AUDIO_OUT_H
+#define PICO_AUDIO_OUT_H
+
+#include "pico_config.h"
+#include "pico_audio.h"
+#include "pico_resample.h"
+#include <pthread.h>
+
+// Device samples per sink write
+#define PICO_AUDIO_OUT_BLOCK    256
+
+// Synth samples needed for one block; device rates down to half the synth
+// rate are supported
+#if PICO_AUDIO_DEVICE_RATE * 2 < PICO_SAMPLE_RATE
+#error "PICO_AUDIO_DEVICE_RATE must be at least PICO_SAMPLE_RATE / 2"
+#endif
+#define PICO_AUDIO_OUT_MAX_IN   (PICO_AUDIO_OUT_BLOCK * 2 + 1)
+
+// PCM Ring
+// Single producer (emulator thread) / single consumer (output thread).
+// head and tail are free-running sample counts; each side only writes
+// its own index, published with release/acquire ordering.
+typedef struct {
+    int16_t data[PICO_AUDIO_RING_SIZE];
+    uint32_t head;              // Written by the producer
+    uint32_t tail;              // Written by the consumer
+    uint32_t played;            // Consumer: samples handed out, silence included
+    uint32_t underruns;         // Consumer found the ring empty
+    uint32_t overruns;          // Producer found the ring full
+    bool starved;               // Consumer-side: last read came up short
+} pico_pcm_ring_t;
+
+void pico_pcm_ring_init(pico_pcm_ring_t* ring);
+uint32_t pico_pcm_ring_readable(const pico_pcm_ring_t* ring);
+uint32_t pico_pcm_ring_writable(const pico_pcm_ring_t* ring);
+
+// Producer: copy in up to n samples, returns how many fit
+uint32_t pico_pcm_ring_write(pico_pcm_ring_t* ring, const int16_t* samples, uint32_t n);
+
+// Producer, zero-copy: contiguous free space, then commit what was filled
+int16_t* pico_pcm_ring_write_span(pico_pcm_ring_t* ring, uint32_t* n);
+void pico_pcm_ring_commit(pico_pcm_ring_t* ring, uint32_t n);
+
+// Consumer: always fills n samples, padding with silence on underrun.
+// Usable directly as a device audio callback.
+void pico_pcm_ring_read(pico_pcm_ring_t* ring, int16_t* out, uint32_t n);
+
+// Audio Sink
+// write() may block; the device's pace is what drains the ring.
+typedef struct pico_audio_sink pico_audio_sink_t;
+struct pico_audio_sink {
+    bool (*write)(pico_audio_sink_t* sink, const int16_t* samples, uint32_t count);
+    void (*close)(pico_audio_sink_t* sink);
+    void* state;
+};
+
+// Raw signed 16-bit mono PCM at PICO_AUDIO_DEVICE_RATE to a file or
+// FIFO, paced to real time
+// (e.g. mkfifo /tmp/pico.pcm; aplay -f S16_LE -r 44100 /tmp/pico.pcm)
+bool pico_audio_sink_open_file(pico_audio_sink_t* sink, const char* path);
+
+// I2S (or an I2S-fed DAC/codec) on the PICO_I2S_* pins
+bool pico_audio_sink_open_i2s(pico_audio_sink_t* sink);
+
+// Audio Output
+typedef struct {
+    pico_pcm_ring_t ring;
+    pico_audio_sink_t sink;
+    
+    // Output thread side: ring -> staging -> resampler -> sink
+    pico_resampler_t resampler;
+    int16_t staging[PICO_RESAMPLE_TAPS + PICO_AUDIO_OUT_MAX_IN];
+    
+    pthread_t thread;
+    bool started;               // Thread to join on stop
+    bool running;               // Output thread is alive; cleared if the sink fails
+    uint32_t lead;              // Samples pump keeps queued
+    
+    // Audio clock (emulator side)
+    uint32_t clock_played;      // ring.played when last polled
+    uint64_t clock_samples;     // Played since the clock was reset
+    uint64_t clock_frames;      // Frames handed out since then
+    uint32_t clock_fps;
+} pico_audio_out_t;
+
+// Takes ownership of the sink and starts the output thread
+bool pico_audio_out_start(pico_audio_out_t* out, const pico_audio_sink_t* sink);
+void pico_audio_out_stop(pico_audio_out_t* out);
+
+// False once stopped or after a failed sink write
+bool pico_audio_out_running(const pico_audio_out_t* out);
+
+// Emulator side, once per frame: renders until the lead (PICO_AUDIO_LEAD,
+// or PICO_AUDIO_CLOCK_LEAD with clock pacing) is queued. Never blocks; a
+// full ring counts an overrun.
+void pico_audio_out_pump(pico_audio_out_t* out, pico_audio_t* audio);
+
+// Audio Clock
+// The device's playback position as the frame clock: returns how many
+// frames at fps became due since the last call, at most
+// PICO_AUDIO_CLOCK_MAX_FRAMES. Starved reads still advance it.
+void pico_audio_out_clock_reset(pico_audio_out_t* out);
+uint32_t pico_audio_out_frames_due(pico_audio_out_t* out, uint32_t fps);
+
+#endif // PICO_AUDIO_OUT_H
@@ -24,6 +24,7 @@
 #define PICO_PALETTE_SIZE   16      // 16 colors
 #define PICO_FPS_DEFAULT    30
 #define PICO_FPS_60         60
+#define PICO_CPU_HZ         8000000 // Cycle budget per second for stat(1)
 
 // Memory Budget Configuration
 // Target: 100KB total, ~80KB used, ~20KB headroom
@@ -31,11 +32,74 @@
 // Core PICO RAM - reduced from 64KB to 32KB (no userData area)
 #define PICO_RAM_SIZE       0x8000  // 32KB
 
-// Lua VM budget
-#define PICO_LUA_HEAP_SIZE  (40 * 1024)  // 40KB for Lua
-
-// Audio buffer (no reverb)
-#define PICO_AUDIO_BUFFER_SIZE  1024     // 1KB audio buffer
+// Lua VM budget: one arena reserved at init, never grown. PICO-8 gives
+// carts 2MB; the bundled carts need up to 1MB (tvstatic, racer). The
+// arena comes from PSRAM where there is some, otherwise it is halved
+// until the heap can spare it, down to PICO_LUA_HEAP_MIN.
+#ifndef PICO_LUA_HEAP_SIZE
+#define PICO_LUA_HEAP_SIZE  (2 * 1024 * 1024)
+#endif
+#ifndef PICO_LUA_HEAP_MIN
+#define PICO_LUA_HEAP_MIN   (128 * 1024)
+#endif
+
+// Lua GC: after each frame the VM spends part of the time left in the
+// frame on collector steps, so collection lands between frames instead
+// of inside _update and _draw. The allocation-driven collector stays on
+// as a backstop, with a lighter step multiplier than Lua's 200.
+#ifndef PICO_GC_IDLE
+#define PICO_GC_IDLE            1
+#endif
+#define PICO_GC_IDLE_PERCENT    50      // Share of the frame's slack
+#define PICO_GC_IDLE_PAUSE      150     // Next idle cycle at this % of live KB
+#define PICO_GC_STEPMUL         100
+
+// Generational GC: in auto mode the VM profiles the first seconds of a
+// cart and moves carts that churn short-lived objects (allocating at
+// least CHURN% of their live heap per second, SURVIVAL% or less of it
+// surviving) to Lua's generational collector
+#ifndef PICO_GC_AUTO_GEN
+#define PICO_GC_AUTO_GEN        1
+#endif
+#define PICO_GC_PROFILE_SECONDS 3
+#define PICO_GC_GEN_CHURN       200
+#define PICO_GC_GEN_SURVIVAL    10
+
+// Audio output ring
+#define PICO_AUDIO_RING_SIZE    2048     // Samples, power of two (4KB, ~93ms)
+#define PICO_AUDIO_LEAD         1536     // Samples kept queued ahead of the device
+
+// serial(0x808) PCM stream buffer, samples at 5512.5Hz (power of two, ~0.37s)
+#define PICO_AUDIO_PCM_STREAM_SIZE 2048
+
+// Audio-clock pacing: frames run as the device plays each frame's worth of
+// samples (735 at 30fps, 367.5 at 60fps) instead of on the LVGL timer,
+// so the ring holds a constant, shorter lead
+#ifndef PICO_AUDIO_CLOCK_PACING
+#define PICO_AUDIO_CLOCK_PACING 0
+#endif
+#define PICO_AUDIO_CLOCK_LEAD   768      // Samples queued ahead in this mode
+#define PICO_AUDIO_CLOCK_POLL_MS 4       // Timer period while polling the clock
+#define PICO_AUDIO_CLOCK_MAX_FRAMES 2    // Catch-up cap; later frames are dropped
+
+// Output device rate; the synth always runs at 22050Hz and a streaming
+// resampler converts (linear, or an 8-tap polyphase FIR when enabled)
+#ifndef PICO_AUDIO_DEVICE_RATE
+#define PICO_AUDIO_DEVICE_RATE  44100
+#endif
+#define PICO_AUDIO_RESAMPLE_FIR 0
+
+// I2S output pins, -1 disables the device sink
+#ifndef PICO_I2S_BCLK_GPIO
+#define PICO_I2S_BCLK_GPIO      -1
+#define PICO_I2S_WS_GPIO        -1
+#define PICO_I2S_DOUT_GPIO      -1
+#endif
+
+// Raw PCM file/FIFO output on hosts without I2S (NULL disables it)
+#ifndef PICO_AUDIO_PCM_PATH
+#define PICO_AUDIO_PCM_PATH     NULL
+#endif
 
 // Display conversion buffer (single line)
 #define PICO_LINE_BUFFER_SIZE   (PICO_SCREEN_WIDTH * 2)  // 256 bytes RGB565
@@ -43,9 +107,32 @@
 // Feature Flags
 #define PICO_ENABLE_AUDIO       1   // Audio synthesis
 #define PICO_ENABLE_MUSIC       1   // Music playback
-#define PICO_ENABLE_REVERB      0   // NO REVERB - saves ~18KB
+#ifndef PICO_ENABLE_REVERB
+#define PICO_ENABLE_REVERB      0   // 0x5F41 reverb, ~2KB (pico_reverb_t)
+#endif
 #define PICO_ENABLE_EXTENDED_MEM 0  // NO userData - saves ~32KB
 #define PICO_ENABLE_TOUCH       1   // Virtual gamepad
+#define PICO_FRAME_HASH_PALETTE 1   // Screen palette changes count as new frames (scanout applies 0x5F10)
+
+// GIF recordings from extcmd("rec") are written here
+#ifndef PICO_CAPTURE_DIR
+#define PICO_CAPTURE_DIR        "/sdcard/tactility/picotility"
+#endif
+
+// Compiled cart chunks are cached here, keyed by a hash of the source,
+// and the least recently used are evicted past the size cap
+#ifndef PICO_LUA_CACHE
+#define PICO_LUA_CACHE          1
+#endif
+#ifndef PICO_LUA_CACHE_DIR
+#define PICO_LUA_CACHE_DIR      PICO_CAPTURE_DIR "/.luac"
+#endif
+#ifndef PICO_LUA_CACHE_MAX_BYTES
+#define PICO_LUA_CACHE_MAX_BYTES (512 * 1024)
+#endif
+// Part of the cache key: bump on any z8lua change to the compiler, opcodes
+// or chunk format so chunks from older builds are never loaded
+#define PICO_LUA_CACHE_VERSION  1
 
 // Debug features (disable for release)
 #define PICO_DEBUG_MEMORY       0   // Memory usage tracking
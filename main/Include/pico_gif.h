@@ -0,0 +1,62 @@
+// pico_gif.h
+// Streaming animated GIF recorder for the 4bpp framebuffer
+
+#ifndef PICO_GIF_H
+#define PICO_GIF_H
+
+#include "pico_config.h"
+#include <stdio.h>
+
+// LZW dictionary is capped at 2^PICO_GIF_LZW_BITS codes and cleared when full
+#define PICO_GIF_LZW_BITS   10
+#define PICO_GIF_DICT_SIZE  (1 << PICO_GIF_LZW_BITS)
+#define PICO_GIF_HASH_SIZE  (PICO_GIF_DICT_SIZE * 2)
+
+// Output is buffered and written to the file in chunks of this size
+#define PICO_GIF_CHUNK_SIZE 512
+
+// Recorder State (~15KB while recording, allocated in pico_gif_start)
+typedef struct {
+    FILE* file;
+    uint8_t* prev;              // Last frame written, packed 4bpp
+    uint16_t* hash;             // LZW hash: code in each slot, 0 when empty
+    uint16_t* keys;             // LZW dictionary: prefix << 4 | pixel per code
+    uint8_t* chunk;             // Pending file output
+    uint16_t chunk_len;
+
+    // LZW bit packer
+    uint32_t bits;
+    uint8_t bit_count;
+    uint8_t code_size;
+    uint16_t next_code;
+    uint8_t block[256];         // GIF sub-block, block[0] is the length
+
+    // Screen palette (0x5F10) behind the global color table, and the one
+    // the last image was drawn with; images under any other carry a local
+    // color table
+    uint8_t global_pal[16];
+    uint8_t pal[16];
+
+    // Frame timing in 1/100s; the last image's delay is patched in place
+    // once the next changed frame (or the end of recording) is reached
+    uint32_t fps;
+    uint32_t time_rem;
+    uint32_t delay_cs;
+    uint32_t delay_pos;         // File offset of the pending delay, 0 if none
+    uint32_t file_pos;          // Bytes already written to the file
+    uint32_t frames;
+    bool error;
+} pico_gif_t;
+
+// Recording; screen_pal is the RAM screen palette at the time
+bool pico_gif_start(pico_gif_t* gif, const char* path, uint32_t fps,
+                    const uint8_t* screen_pal);
+void pico_gif_frame(pico_gif_t* gif, const uint8_t* screen, const uint8_t* screen_pal);
+bool pico_gif_stop(pico_gif_t* gif);
+
+// Query
+static inline bool pico_gif_active(const pico_gif_t* gif) {
+    return gif->file != NULL;
+}
+
+#endif // PICO_GIF_H
@@ -4,9 +4,42 @@
 #ifndef PICO_GRAPHICS_H
 #define PICO_GRAPHICS_H
 
+#include <stddef.h>
 #include "pico_config.h"
 #include "pico_ram.h"
 
+// Derived Draw State
+// Values computed from the raw 0x5F00-0x5F3F bytes so primitives don't
+// re-derive them per pixel. Rebuilt lazily after the draw state changes.
+typedef struct {
+    int16_t camera_x;
+    int16_t camera_y;
+    int16_t clip_xb;            // Screen-space clip, exclusive end
+    int16_t clip_yb;
+    int16_t clip_xe;
+    int16_t clip_ye;
+    uint8_t pal[16];            // Draw palette with transparency bit stripped
+    uint16_t transparent;       // Bit n set if color n is transparent
+    uint16_t fillp;             // 16-bit fill pattern word
+    bool fillp_trans;           // Pattern "1" bits are transparent
+    uint8_t pen[2];             // Palette-mapped primary/secondary pen
+} pico_draw_cache_t;
+
+// Custom Font Cache
+// Metrics decoded once from the custom font at 0x5600 so printing with it
+// costs one glyph blit per character. Rebuilt lazily after 0x5600-0x5DFF
+// changes. Glyph row bits are read straight from RAM.
+typedef struct {
+    uint8_t width;              // 0x5600: advance for chars < 128
+    uint8_t width_hi;           // 0x5601: advance for chars >= 128
+    uint8_t height;             // 0x5602: line height
+    int8_t offset_x;            // 0x5603
+    int8_t offset_y;            // 0x5604
+    uint8_t advance[256];       // Per-char advance, size adjustments applied
+    uint8_t rows[256];          // Rows to blit (trailing blank rows trimmed)
+    uint8_t raised[32];         // Bitset: char drawn one pixel higher
+} pico_font_cache_t;
+
 // Graphics Context
 typedef struct {
     pico_ram_t* ram;
@@ -15,16 +48,32 @@ typedef struct {
     uint8_t dirty_bottom;
     bool needs_flip;
     const uint8_t* font_data;
+    pico_draw_cache_t draw;
+    bool draw_dirty;            // draw needs rebuilding from RAM
+    pico_font_cache_t font;
+    bool font_dirty;            // font needs rebuilding from RAM
+    // RAM written by print (\^@, \^!), for subsystems outside graphics;
+    // graphics' own caches are invalidated when this is unset
+    void (*mem_written)(uint16_t addr, uint16_t len);
 } pico_graphics_t;
 
 // Initialization
 void pico_graphics_init(pico_graphics_t* gfx, pico_ram_t* ram);
 void pico_graphics_reset(pico_graphics_t* gfx);
 
+// Derived State Invalidation
+// Call after writing draw state (0x5F00-0x5F3F) or the custom font
+// (0x5600-0x5DFF) behind the API's back; pico_graphics_reset drops both
+void pico_graphics_mem_written(pico_graphics_t* gfx, uint16_t addr, uint16_t len);
+
 // Screen Management
 void pico_cls(pico_graphics_t* gfx, uint8_t color);
 void pico_flip(pico_graphics_t* gfx);
 
+// Hash of screen RAM, plus the screen palette when with_palette is set.
+// Equal hashes mean the scanout is unchanged.
+uint32_t pico_frame_hash(const pico_ram_t* ram, bool with_palette);
+
 // Drawing Primitives
 void pico_pset(pico_graphics_t* gfx, int16_t x, int16_t y, uint8_t color);
 uint8_t pico_pget(pico_graphics_t* gfx, int16_t x, int16_t y);
@@ -48,7 +97,13 @@ uint8_t pico_mget(pico_graphics_t* gfx, int16_t x, int16_t y);
 void pico_mset(pico_graphics_t* gfx, int16_t x, int16_t y, uint8_t val);
 
 // Text Drawing
-void pico_print(pico_graphics_t* gfx, const char* str, int16_t x, int16_t y, uint8_t color);
+// Strings are P8SCII: control codes 0-15 and \^ commands are interpreted.
+// Returns the rightmost x drawn. The cursor moves to the next line unless
+// the string ends with \0.
+int16_t pico_print(pico_graphics_t* gfx, const char* str, size_t len,
+                   int16_t x, int16_t y, uint8_t color);
+// Print at the cursor, scrolling the screen when it runs off the bottom
+int16_t pico_print_cursor(pico_graphics_t* gfx, const char* str, size_t len, uint8_t color);
 void pico_print_char(pico_graphics_t* gfx, char c, int16_t x, int16_t y, uint8_t color);
 
 // State Management
@@ -0,0 +1,54 @@
+// pico_heap.h
+// Two-level segregated fit (TLSF) allocator over one fixed arena
+
+#ifndef PICO_HEAP_H
+#define PICO_HEAP_H
+
+#include "pico_config.h"
+#include <stddef.h>
+
+// Size classes: the first level is the power of two of the size, the
+// second splits it into PICO_HEAP_SL_COUNT linear steps. Sizes below
+// 1 << PICO_HEAP_FL_SHIFT share first-level class 0.
+#define PICO_HEAP_ALIGN         8
+#define PICO_HEAP_SL_LOG2       3
+#define PICO_HEAP_SL_COUNT      (1 << PICO_HEAP_SL_LOG2)
+#define PICO_HEAP_FL_SHIFT      (PICO_HEAP_SL_LOG2 + 3)
+#define PICO_HEAP_FL_MAX        24      // Largest block just under 16MB
+#define PICO_HEAP_FL_COUNT      (PICO_HEAP_FL_MAX - PICO_HEAP_FL_SHIFT + 1)
+
+typedef struct pico_heap_block pico_heap_block_t;
+
+// Heap Control (placed at the start of the arena, ~0.6KB on ESP32)
+typedef struct {
+    uint32_t fl_bitmap;                 // First levels with a free block
+    uint32_t sl_bitmap[PICO_HEAP_FL_COUNT];
+    pico_heap_block_t* free[PICO_HEAP_FL_COUNT][PICO_HEAP_SL_COUNT];
+    size_t size;                        // Arena bytes, control included
+    size_t used;                        // Allocated blocks, headers included
+    size_t peak;                        // High-water mark of used
+} pico_heap_t;
+
+// Lays out a heap over mem; NULL if size can't hold the control block
+// and one allocation. Nothing to destroy: drop the arena.
+pico_heap_t* pico_heap_create(void* mem, size_t size);
+
+// Constant time in the arena size. alloc/realloc return NULL when no
+// free block fits; shrinking in place always succeeds.
+void* pico_heap_alloc(pico_heap_t* heap, size_t size);
+void* pico_heap_realloc(pico_heap_t* heap, void* ptr, size_t size);
+void pico_heap_free(pico_heap_t* heap, void* ptr);
+
+// Payload on a power-of-two boundary; freed with pico_heap_free
+void* pico_heap_alloc_aligned(pico_heap_t* heap, size_t size, size_t align);
+
+// Query
+static inline size_t pico_heap_used(const pico_heap_t* heap) {
+    return heap->used;
+}
+
+static inline size_t pico_heap_peak(const pico_heap_t* heap) {
+    return heap->peak;
+}
+
+#endif // PICO_HEAP_H
@@ -28,6 +28,23 @@ bool pico_lua_call_update(pico_vm_t* vm);
 bool pico_lua_call_update60(pico_vm_t* vm);
 bool pico_lua_call_draw(pico_vm_t* vm);
 
+// Lua GC: one collector step, true when it ended a cycle (every step
+// does in generational mode)
+bool pico_lua_gc_step(pico_vm_t* vm);
+void pico_lua_gc_full(pico_vm_t* vm);
+void pico_lua_gc_generational(pico_vm_t* vm, bool on);
+uint32_t pico_lua_gc_kb(pico_vm_t* vm);
+// Cycles finished so far, and the heap in KB when the last one finished
+uint32_t pico_lua_gc_cycles(pico_vm_t* vm, uint32_t* live_kb);
+
+// PICO-8 CPU meter: starts a frame (keeping the last one's total in
+// vm->cpu_cycles), and cycles charged since the frame started
+void pico_lua_cpu_frame(pico_vm_t* vm);
+uint32_t pico_lua_cpu_used(pico_vm_t* vm);
+
+// Reseed rnd(); lets tests get repeatable frames
+void pico_lua_seed(pico_vm_t* vm, uint32_t seed);
+
 // Get last error message
 const char* pico_lua_get_error(pico_vm_t* vm);
 
@@ -22,6 +22,19 @@
 // 0x6000-0x7FFF: Screen buffer (8KB)
 // 0x8000-0xFFFF: User data (NOT INCLUDED - saves 32KB)
 
+#define PICO_ADDR_SFX           0x3200
+#define PICO_ADDR_CUSTOM_FONT   0x5600
+#define PICO_ADDR_PERSIST       0x5E00
+#define PICO_ADDR_DRAW_STATE    0x5F00
+#define PICO_ADDR_HW_STATE      0x5F40
+#define PICO_ADDR_SCREEN        0x6000
+
+// True if [addr, addr + len) overlaps [start, end)
+static inline bool pico_range_overlaps(uint32_t addr, uint32_t len,
+                                       uint32_t start, uint32_t end) {
+    return len > 0 && addr < end && addr + len > start;
+}
+
 // Note structure (2 bytes) - matches fake-08 bit layout exactly
 typedef struct __attribute__((packed)) {
     uint8_t data[2];
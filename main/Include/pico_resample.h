@@ -0,0 +1,32 @@
+// pico_resample.h
+// Streaming fixed-point sample-rate converter (synth rate -> device rate)
+
+#ifndef PICO_RESAMPLE_H
+#define PICO_RESAMPLE_H
+
+#include "pico_config.h"
+#include "pico_wavetable.h"
+
+// Resampler State (~32 bytes)
+// Output sample k reads the PICO_RESAMPLE_TAPS inputs starting at
+// floor(pos), interpolating between taps 3 and 4 by pos's fraction.
+typedef struct {
+    uint64_t step;              // Input samples per output sample, 32.32
+    uint32_t frac;              // Position past the oldest history sample, 0.32
+    bool fir;                   // Polyphase FIR instead of linear
+    int16_t hist[PICO_RESAMPLE_TAPS];
+} pico_resampler_t;
+
+void pico_resampler_init(pico_resampler_t* rs, uint32_t in_rate, uint32_t out_rate, bool fir);
+
+// Input samples the next n outputs will consume
+static inline uint32_t pico_resampler_input_for(const pico_resampler_t* rs, uint32_t n) {
+    return (uint32_t)((rs->frac + rs->step * n) >> 32);
+}
+
+// Converts exactly pico_resampler_input_for(n) samples at in into n
+// outputs. in[-PICO_RESAMPLE_TAPS..-1] must be writable scratch: the
+// history is placed there so every window is a plain pointer.
+void pico_resampler_process(pico_resampler_t* rs, int16_t* in, int16_t* out, uint32_t n);
+
+#endif // PICO_RESAMPLE_H
@@ -0,0 +1,42 @@
+// pico_slab.h
+// Size-class slab pools for small objects, carved from a pico_heap
+
+#ifndef PICO_SLAB_H
+#define PICO_SLAB_H
+
+#include "pico_heap.h"
+
+// Requests up to PICO_SLAB_MAX bytes come from per-class pages, in
+// PICO_SLAB_STEP classes. Pages are aligned to their size so a slot
+// finds its page by masking its address, and a bitmap over the arena
+// tells slots from heap blocks.
+#define PICO_SLAB_STEP          8
+#define PICO_SLAB_MAX           64
+#define PICO_SLAB_CLASSES       (PICO_SLAB_MAX / PICO_SLAB_STEP)
+#define PICO_SLAB_PAGE_SIZE     512
+
+typedef struct pico_slab_page pico_slab_page_t;
+
+// Slab Allocator
+typedef struct {
+    pico_heap_t* heap;                          // Pages and large blocks
+    pico_slab_page_t* partial[PICO_SLAB_CLASSES];   // Pages with a free slot
+    pico_slab_page_t* spare;                    // Empty page kept for any class
+    uint8_t* base;                              // Arena, rounded down to a page
+    uint32_t* pages;                            // Bit per arena page in use as a slab
+    size_t page_count;
+} pico_slab_t;
+
+// Takes the page bitmap from the heap; false if it doesn't fit
+bool pico_slab_init(pico_slab_t* slab, pico_heap_t* heap);
+
+static inline bool pico_slab_fits(size_t size) {
+    return size > 0 && size <= PICO_SLAB_MAX;
+}
+
+// Small sizes pop a slot, larger ones (or small ones when no page can
+// be had) go to the heap. The caller passes each block's current size
+// back in, the way Lua's allocator does; osize is ignored for NULL.
+void* pico_slab_realloc(pico_slab_t* slab, void* ptr, size_t osize, size_t nsize);
+
+#endif // PICO_SLAB_H
@@ -10,6 +10,8 @@
 #include "pico_audio.h"
 #include "pico_input.h"
 #include "pico_cart.h"
+#include "pico_gif.h"
+#include "pico_slab.h"
 
 // VM State
 typedef enum {
@@ -19,6 +21,13 @@ typedef enum {
     PICO_VM_ERROR,
 } pico_vm_state_t;
 
+// Lua collector, per cart
+typedef enum {
+    PICO_GC_AUTO,               // Incremental, generational if profiling says so
+    PICO_GC_INCREMENTAL,
+    PICO_GC_GENERATIONAL,
+} pico_gc_mode_t;
+
 // VM Context
 typedef struct {
     pico_vm_state_t state;
@@ -34,8 +43,12 @@ typedef struct {
     char* lua_code;
     size_t lua_code_len;
     
-    // Lua state (opaque pointer)
+    // Lua state (opaque pointer), allocating only from its own arena
     void* lua_state;
+    void* lua_arena;
+    pico_heap_t* lua_heap;
+    pico_slab_t lua_slab;       // Small objects, in front of lua_heap
+    uint32_t lua_alloc_bytes;   // Running total requested, wraps
     
     // Callback flags
     bool has_init;
@@ -47,6 +60,29 @@ typedef struct {
     uint32_t frame_count;
     uint32_t target_fps;
     uint32_t last_frame_time;
+    uint32_t frame_us;          // Last step, callbacks through flip
+    uint32_t gc_us;             // Idle GC after the last step, if any
+    uint32_t gc_idle_kb;        // Idle GC waits for the heap to reach this
+    uint32_t cpu_frame_start;   // Lua cycle count when the frame began
+    uint32_t cpu_sys;           // Builtin cycles charged this frame
+    uint32_t cpu_cycles;        // PICO-8 cycles used by the last frame
+    
+    // Collector mode and the profile window that picks it in auto mode
+    pico_gc_mode_t gc_mode;
+    bool gc_generational;       // Collector currently generational
+    uint32_t gc_profile_frame;  // Frame the window ends on, 0 when idle
+    uint32_t gc_profile_alloc;  // lua_alloc_bytes at the window start
+    uint32_t gc_profile_kb;     // Live heap after the last cycle before it
+    uint32_t gc_profile_cycles; // Cycles finished before the window
+    uint32_t gc_profile_us;     // Idle GC time over the window
+    uint32_t gc_inc_us;         // Per frame in the incremental window
+    
+    // Scanout hash of the last two frames (see pico_frame_hash)
+    uint32_t frame_hash;
+    uint32_t prev_frame_hash;
+    
+    // Gameplay capture
+    pico_gif_t gif;
     
     // Error handling
     char error_msg[128];
@@ -70,9 +106,28 @@ void pico_vm_resume(pico_vm_t* vm);
 void pico_vm_step(pico_vm_t* vm);
 void pico_vm_main_loop(pico_vm_t* vm);
 
+// Steps the Lua collector in the idle time before deadline_us, taken on
+// the pico_vm_time_us() clock. Call after the frame is shown and audio
+// is queued.
+void pico_vm_gc_idle(pico_vm_t* vm, uint32_t deadline_us);
+uint32_t pico_vm_time_us(void);
+
+// Collector mode; reset to PICO_GC_AUTO by each cart load
+void pico_vm_set_gc_mode(pico_vm_t* vm, pico_gc_mode_t mode);
+
+// Recording (GIF streamed to PICO_CAPTURE_DIR)
+bool pico_vm_record_start(pico_vm_t* vm);
+bool pico_vm_record_stop(pico_vm_t* vm);
+
 // Query
 const char* pico_vm_get_error(pico_vm_t* vm);
 uint32_t pico_vm_get_fps(pico_vm_t* vm);
 uint32_t pico_vm_get_frame_count(pico_vm_t* vm);
+uint32_t pico_vm_get_gc_us(pico_vm_t* vm);
+
+// True when the last step produced a different picture than the one before
+static inline bool pico_vm_frame_changed(const pico_vm_t* vm) {
+    return vm->frame_count <= 1 || vm->frame_hash != vm->prev_frame_hash;
+}
 
 #endif // PICO_VM_H
@@ -0,0 +1,57 @@
+// pico_wavetable.h
+// Oscillator and resampler tables generated at compile time (see pico_wavetable.cpp)
+
+#ifndef PICO_WAVETABLE_H
+#define PICO_WAVETABLE_H
+
+#include "pico_config.h"
+
+#define PICO_WAVETABLE_BITS 8
+#define PICO_WAVETABLE_SIZE (1 << PICO_WAVETABLE_BITS)
+#define PICO_NOTE_COUNT     64
+
+#define PICO_RESAMPLE_TAPS          8
+#define PICO_RESAMPLE_PHASE_BITS    5
+#define PICO_RESAMPLE_PHASES        (1 << PICO_RESAMPLE_PHASE_BITS)
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// One cycle per waveform (indexed by pico_waveform_t), looked up with
+// phase >> (32 - PICO_WAVETABLE_BITS). The noise row is unused.
+typedef struct {
+    int16_t wave[8][PICO_WAVETABLE_SIZE];
+} pico_wavetables_t;
+
+// Per-note pitch: 32-bit phase increment per sample at PICO_SAMPLE_RATE,
+// and frequency in Hz (16.16). C-0 = 65.41Hz, A-2 = 440Hz.
+typedef struct {
+    uint32_t phase_inc[PICO_NOTE_COUNT];
+    fix32_t freq[PICO_NOTE_COUNT];
+} pico_note_tables_t;
+
+// Polyphase FIR for 22050Hz -> PICO_AUDIO_DEVICE_RATE: Hann-windowed sinc,
+// Q15, one row per fractional position between taps 3 and 4
+typedef struct {
+    int16_t coef[PICO_RESAMPLE_PHASES][PICO_RESAMPLE_TAPS];
+} pico_resample_fir_t;
+
+// Distortion waveshaper over a channel's +-16384 range: entry i is the
+// output for input (i - 128) * 128, interpolated between entries
+#define PICO_DISTORT_SIZE   257
+
+typedef struct {
+    int16_t curve[PICO_DISTORT_SIZE];
+} pico_distort_table_t;
+
+extern const pico_wavetables_t pico_wavetables;
+extern const pico_note_tables_t pico_note_tables;
+extern const pico_resample_fir_t pico_resample_fir;
+extern const pico_distort_table_t pico_distort_table;
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // PICO_WAVETABLE_H
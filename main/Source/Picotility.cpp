@@ -22,7 +22,8 @@
 static Picotility* g_instance = nullptr;
 
 /* ── Pre-computed PICO-8 palette in RGB565 for direct buffer writes ─── */
-static const uint16_t pico_palette_565[16] = {
+/* 0-15, then the extended colors 128-143 the screen palette can select */
+static const uint16_t pico_palette_565[32] = {
     0x0000, /*  0: black       */
     0x194A, /*  1: dark blue   */
     0x792A, /*  2: dark purple */
@@ -39,6 +40,22 @@ static const uint16_t pico_palette_565[16] = {
     0x83B3, /* 13: indigo      */
     0xFBB5, /* 14: pink        */
     0xFDEC, /* 15: peach       */
+    0x28C2, /* 128: brownish black */
+    0x10E6, /* 129: darker blue    */
+    0x4106, /* 130: darker purple  */
+    0x128B, /* 131: blue green     */
+    0x7165, /* 132: dark brown     */
+    0x4987, /* 133: darker gray    */
+    0xA44F, /* 134: medium gray    */
+    0xF76F, /* 135: light yellow   */
+    0xB88A, /* 136: dark red       */
+    0xFB64, /* 137: dark orange    */
+    0xAF25, /* 138: lime green     */
+    0x05A8, /* 139: medium green   */
+    0x02D6, /* 140: true blue      */
+    0x722C, /* 141: mauve          */
+    0xFB6B, /* 142: dark peach     */
+    0xFCF0, /* 143: peach          */
 };
 
 /* ── Keyboard mapping ────────────────────────────────────────────────── */
@@ -98,6 +115,7 @@ static const uint8_t all_buttons[NUM_BUTTONS] = {
 
 /* ── Shadow buffer for delta rendering ───────────────────────────────── */
 static uint8_t prev_framebuffer[PICO_FRAMEBUFFER_SIZE];
+static uint8_t prev_screen_pal[16];
 
 /* ── Cart file management (file-scope statics) ───────────────────────── */
 
@@ -140,9 +158,16 @@ void Picotility::renderDisplay(bool forceFull) {
     uint8_t* fb = ram->screen;
     uint16_t* buf = cbuf;
 
-    /* Check if framebuffer changed at all (quick memcmp) */
-    if (!forceFull && memcmp(fb, prev_framebuffer, PICO_FRAMEBUFFER_SIZE) == 0) {
-        return;
+    /* Scan out through the screen palette (0x5F10); a change to it
+       recolors every pixel */
+    if (memcmp(prev_screen_pal, ram->ds.screen_pal, 16) != 0) {
+        memcpy(prev_screen_pal, ram->ds.screen_pal, 16);
+        forceFull = true;
+    }
+    uint16_t colors[16];
+    for (int c = 0; c < 16; c++) {
+        uint8_t p = prev_screen_pal[c];
+        colors[c] = pico_palette_565[(p & 0x0F) | ((p & 0x80) >> 3)];
     }
 
     /* Delta render: only update changed pixels */
@@ -153,8 +178,8 @@ void Picotility::renderDisplay(bool forceFull) {
             int px = i * 2;
             int lo = fb[i] & 0x0F;
             int hi = (fb[i] >> 4) & 0x0F;
-            buf[px] = pico_palette_565[lo];
-            buf[px + 1] = pico_palette_565[hi];
+            buf[px] = colors[lo];
+            buf[px + 1] = colors[hi];
         }
     }
 
@@ -206,23 +231,44 @@ void Picotility::emuTimerCb(lv_timer_t* timer) {
     }
 
     auto* self = g_instance;
+    uint32_t fps = self->vm.target_fps > 0 ? self->vm.target_fps : PICO_FPS_DEFAULT;
+    uint32_t tick_start = pico_vm_time_us();
+
+    /* One frame per tick, or with audio-clock pacing as many frames as
+       the device has played audio for since the last poll. If the output
+       thread has died the clock stops, so go back to the frame timer. */
+    uint32_t frames = 1;
+#if PICO_AUDIO_CLOCK_PACING
+    if (pico_audio_out_running(&self->audioOut)) {
+        frames = pico_audio_out_frames_due(&self->audioOut, fps);
+    } else if (self->emuTimer) {
+        lv_timer_set_period(self->emuTimer, 1000 / fps);
+    }
+#endif
 
-    /* Decrement key hold counters and release expired keys */
-    for (int i = 0; i < NUM_BUTTONS; i++) {
-        if (self->keyHold[i] > 0) {
-            self->keyHold[i]--;
-            if (self->keyHold[i] == 0) {
-                pico_input_set_button(&self->vm.input, PICO_PLAYER_0,
-                                      all_buttons[i], false);
+    bool changed = false;
+    for (uint32_t f = 0; f < frames && self->vm.state != PICO_VM_ERROR; f++) {
+        /* Decrement key hold counters and release expired keys */
+        for (int i = 0; i < NUM_BUTTONS; i++) {
+            if (self->keyHold[i] > 0) {
+                self->keyHold[i]--;
+                if (self->keyHold[i] == 0) {
+                    pico_input_set_button(&self->vm.input, PICO_PLAYER_0,
+                                          all_buttons[i], false);
+                }
             }
         }
-    }
 
-    /* Update input state (copies current -> previous for btnp) */
-    pico_input_update(&self->vm.input);
+        /* Update input state (copies current -> previous for btnp) */
+        pico_input_update(&self->vm.input);
+
+        /* Step the VM (calls _update/_draw in Lua) */
+        pico_vm_step(&self->vm);
+        changed |= pico_vm_frame_changed(&self->vm);
+    }
 
-    /* Step the VM (calls _update/_draw in Lua) */
-    pico_vm_step(&self->vm);
+    /* Top up the audio ring; the output thread drains it at device pace */
+    pico_audio_out_pump(&self->audioOut, &self->vm.audio);
 
     /* Check for VM error — show error and return to menu */
     if (self->vm.state == PICO_VM_ERROR) {
@@ -240,8 +286,16 @@ void Picotility::emuTimerCb(lv_timer_t* timer) {
         return;
     }
 
-    /* Render if anything changed */
-    self->renderDisplay(false);
+    /* Render only if a frame hash changed */
+    if (changed) {
+        self->renderDisplay(false);
+    }
+
+    /* Give the collector part of what is left of the frame period, unless
+       this tick is catching up on frames */
+    if (frames == 1) {
+        pico_vm_gc_idle(&self->vm, tick_start + 1000000u / fps);
+    }
 }
 
 /* ── Key event handler ───────────────────────────────────────────────── */
@@ -323,15 +377,23 @@ void Picotility::startCartFromPath(const char* path) {
 
     /* Reset shadow buffer */
     memset(prev_framebuffer, 0xFF, sizeof(prev_framebuffer));
+    memset(prev_screen_pal, 0xFF, sizeof(prev_screen_pal));
     memset(keyHold, 0, sizeof(keyHold));
 
     /* Clear canvas buffer to black */
     memset(cbuf, 0, sizeof(cbuf));
     renderDisplay(false);
 
-    /* Update timer period based on cart's target FPS */
+    /* Update timer period based on cart's target FPS; with audio-clock
+       pacing the timer only polls the device position */
     if (emuTimer) {
         uint32_t period = 1000 / (vm.target_fps > 0 ? vm.target_fps : 30);
+#if PICO_AUDIO_CLOCK_PACING
+        if (pico_audio_out_running(&audioOut)) {
+            period = PICO_AUDIO_CLOCK_POLL_MS;
+            pico_audio_out_clock_reset(&audioOut);
+        }
+#endif
         lv_timer_set_period(emuTimer, period);
     }
 }
@@ -400,6 +462,20 @@ void Picotility::buildCartList(lv_obj_t* list) {
     }
 }
 
+/* ── Audio output ────────────────────────────────────────────────────── */
+
+void Picotility::startAudio() {
+    pico_audio_sink_t sink{};
+    if (!pico_audio_sink_open_i2s(&sink) &&
+        !pico_audio_sink_open_file(&sink, PICO_AUDIO_PCM_PATH)) {
+        PICO_LOG("audio: no output sink");
+        return;
+    }
+    if (!pico_audio_out_start(&audioOut, &sink)) {
+        PICO_LOG("audio: output thread failed to start");
+    }
+}
+
 /* ── App lifecycle ───────────────────────────────────────────────────── */
 
 void Picotility::onShow(AppHandle app, lv_obj_t* parent) {
@@ -475,6 +551,8 @@ void Picotility::onShow(AppHandle app, lv_obj_t* parent) {
     /* Emulation timer (starts paused — only runs when Running) */
     emuTimer = lv_timer_create(emuTimerCb, 1000 / PICO_FPS_DEFAULT, nullptr);
 
+    startAudio();
+
     /* Seed random */
     srand((unsigned)lv_tick_get());
 }
@@ -488,6 +566,7 @@ void Picotility::onHide(AppHandle app) {
         lv_timer_delete(emuTimer);
         emuTimer = nullptr;
     }
+    pico_audio_out_stop(&audioOut);
     if (initialized) {
         pico_vm_shutdown(&vm);
         initialized = false;
@@ -1,7 +1,10 @@
 // pico_audio.c
-// PICO-8 audio implementation (no reverb)
+// PICO-8 audio implementation: synth, music sequencer and filters
 
 #include "pico_audio.h"
+#include "pico_wavetable.h"
+#include <stddef.h>
+#include <stdlib.h>
 #include <string.h>
 #include <stdio.h>
 
@@ -12,87 +15,40 @@
 #define PICO_LOG(fmt, ...) ((void)0)
 #endif
 
-// PICO-8 note frequencies (C-0 to C-5, 64 notes) as fix32
-static const fix32_t NOTE_FREQ[] = {
-    1079,  1144,  1212,  1285,  1361,  1442,  1528,  1619,  1716,  1818,  1926,  2041,
-    2162,  2291,  2427,  2572,  2725,  2887,  3059,  3241,  3434,  3639,  3856,  4086,
-    4330,  4588,  4861,  5151,  5458,  5783,  6127,  6492,  6878,  7288,  7722,  8181,
-    8670,  9185,  9732, 10311, 10926, 11576, 12265, 12995, 13768, 14588, 15457, 16376,
-    17352, 18382, 19477, 20637, 21866, 23166, 24545, 26006, 27553, 29192, 30930, 32770,
-    34716, 36781, 38968, 41285,
-};
+#define WAVETABLE_SHIFT (32 - PICO_WAVETABLE_BITS)
+
+static inline int16_t noise_next(uint16_t* lfsr) {
+    uint16_t bit = ((*lfsr >> 0) ^ (*lfsr >> 2) ^ (*lfsr >> 3) ^ (*lfsr >> 5)) & 1;
+    *lfsr = (*lfsr >> 1) | (bit << 15);
+    return (int16_t)(((int32_t)*lfsr - 0x8000) >> 1);
+}
 
 int16_t pico_wave_sample(pico_waveform_t wave, uint32_t phase, uint16_t* lfsr) {
-    uint32_t pos = phase >> 16;
-    int32_t sample = 0;
-    
-    switch (wave) {
-        case PICO_WAVE_TRIANGLE:
-            if (pos < 0x8000) {
-                sample = (pos * 2) - 0x8000;
-            } else {
-                sample = 0x8000 - ((pos - 0x8000) * 2);
-            }
-            break;
-            
-        case PICO_WAVE_TILTED:
-            if (pos < 0xE000) {
-                sample = (pos * 0x10000 / 0xE000) - 0x8000;
-            } else {
-                sample = 0x8000 - ((pos - 0xE000) * 0x10000 / 0x2000);
-            }
-            break;
-            
-        case PICO_WAVE_SAWTOOTH:
-            sample = pos - 0x8000;
-            break;
-            
-        case PICO_WAVE_SQUARE:
-            sample = (pos < 0x8000) ? -0x7FFF : 0x7FFF;
-            break;
-            
-        case PICO_WAVE_PULSE:
-            sample = (pos < 0x4000) ? -0x7FFF : 0x7FFF;
-            break;
-            
-        case PICO_WAVE_ORGAN:
-            {
-                int32_t t1, t2;
-                if (pos < 0x8000) {
-                    t1 = (pos * 2) - 0x8000;
-                } else {
-                    t1 = 0x8000 - ((pos - 0x8000) * 2);
-                }
-                uint32_t pos2 = (pos * 2) & 0xFFFF;
-                if (pos2 < 0x8000) {
-                    t2 = (pos2 * 2) - 0x8000;
-                } else {
-                    t2 = 0x8000 - ((pos2 - 0x8000) * 2);
-                }
-                sample = (t1 + t2 / 2) * 2 / 3;
-            }
-            break;
-            
-        case PICO_WAVE_NOISE:
-            {
-                uint16_t bit = ((*lfsr >> 0) ^ (*lfsr >> 2) ^ 
-                               (*lfsr >> 3) ^ (*lfsr >> 5)) & 1;
-                *lfsr = (*lfsr >> 1) | (bit << 15);
-                sample = ((*lfsr & 0xFFFF) - 0x8000);
-            }
-            break;
-            
-        case PICO_WAVE_PHASER:
-            {
-                uint32_t pos2 = (pos + 0x4000) & 0xFFFF;
-                sample = ((pos - 0x8000) + (pos2 - 0x8000)) / 2;
-            }
-            break;
+    if (wave == PICO_WAVE_NOISE) {
+        return noise_next(lfsr);
     }
-    
-    return (int16_t)(sample >> 1);
+    return pico_wavetables.wave[wave & 7][phase >> WAVETABLE_SHIFT];
+}
+
+#define MUSIC_GAIN_ONE  (1 << 16)
+
+// Gain with left samples of the fade to go. Taken from the fade's end
+// points rather than summed from a per-sample step, which rounds to
+// zero once a fade runs past 65536 samples.
+static inline int32_t fade_gain(const pico_music_state_t* m, uint32_t left) {
+    return m->fade_to + (int32_t)((int64_t)(m->fade_from - m->fade_to) * left / m->fade_total);
+}
+
+static void fade_start(pico_music_state_t* m, int32_t from, int32_t to, uint32_t samples) {
+    m->gain = from;
+    m->fade_from = from;
+    m->fade_to = to;
+    m->fade_total = samples;
+    m->fade_left = samples;
 }
 
+static void status_publish(pico_audio_t* audio, uint32_t pattern_pos);
+
 void pico_audio_init(pico_audio_t* audio, pico_ram_t* ram) {
     memset(audio, 0, sizeof(pico_audio_t));
     audio->ram = ram;
@@ -101,17 +57,32 @@ void pico_audio_init(pico_audio_t* audio, pico_ram_t* ram) {
     for (int i = 0; i < PICO_CHANNELS; i++) {
         audio->channels[i].sfx_index = -1;
         audio->channels[i].noise_lfsr = 0xACE1;
+        audio->voices[i].sfx_index = -1;
+        audio->voices[i].instrument = true;
+        audio->voices[i].noise_lfsr = 0xACE1;
     }
     
     audio->music.pattern_index = -1;
+    audio->music.gain = MUSIC_GAIN_ONE;
+    status_publish(audio, 0);
 }
 
 void pico_audio_reset(pico_audio_t* audio) {
     for (int i = 0; i < PICO_CHANNELS; i++) {
         audio->channels[i].sfx_index = -1;
+        audio->channels[i].music = false;
+        audio->voices[i].sfx_index = -1;
     }
+    for (int i = 0; i < PICO_SFX_COUNT; i++) {
+        audio->sfx_cache[i].valid = false;
+    }
+    memset(&audio->music, 0, sizeof(audio->music));
+    memset(audio->filters, 0, sizeof(audio->filters));
+    memset(audio->filter_regs, 0, sizeof(audio->filter_regs));
+    memset(&audio->pcm, 0, sizeof(audio->pcm));
     audio->music.pattern_index = -1;
-    audio->buffer_pos = 0;
+    audio->music.gain = MUSIC_GAIN_ONE;
+    status_publish(audio, 0);
 }
 
 void pico_audio_shutdown(pico_audio_t* audio) {
@@ -119,8 +90,141 @@ void pico_audio_shutdown(pico_audio_t* audio) {
 }
 
 fix32_t pico_note_to_freq(uint8_t note) {
-    if (note >= 64) note = 63;
-    return NOTE_FREQ[note];
+    if (note >= PICO_NOTE_COUNT) note = PICO_NOTE_COUNT - 1;
+    return pico_note_tables.freq[note];
+}
+
+// SFX Timing
+
+static uint32_t sfx_samples_per_tick(const pico_sfx_t* sfx) {
+    uint32_t speed = sfx->speed;
+    if (speed == 0) speed = 1;
+    return (PICO_SAMPLE_RATE * speed) / 120;
+}
+
+static bool sfx_loops(const pico_sfx_t* sfx) {
+    return sfx->loop_start < sfx->loop_end;
+}
+
+// Notes played before a non-looping sfx ends. loop_end == 0 with a
+// loop_start set is PICO-8's "length" mode.
+static uint8_t sfx_length(const pico_sfx_t* sfx) {
+    if (sfx->loop_end == 0 && sfx->loop_start > 0) {
+        return sfx->loop_start < PICO_NOTES_PER_SFX ? sfx->loop_start : PICO_NOTES_PER_SFX;
+    }
+    return PICO_NOTES_PER_SFX;
+}
+
+// SFX Cache
+
+static const pico_sfx_cache_t* sfx_decoded(pico_audio_t* audio, uint8_t n) {
+    pico_sfx_cache_t* cache = &audio->sfx_cache[n];
+    if (!cache->valid) {
+        const pico_sfx_t* sfx = &audio->ram->sfx[n];
+        for (int j = 0; j < PICO_NOTES_PER_SFX; j++) {
+            const pico_note_t* note = &sfx->notes[j];
+            pico_note_decoded_t* d = &cache->notes[j];
+            d->key = pico_note_key(note);
+            d->waveform = pico_note_waveform(note) | (pico_note_custom(note) ? PICO_NOTE_CUSTOM : 0);
+            d->volume = pico_note_volume(note);
+            d->effect = pico_note_effect(note);
+            d->phase_inc = pico_note_tables.phase_inc[d->key];
+        }
+        cache->samples_per_tick = sfx_samples_per_tick(sfx);
+        cache->valid = true;
+    }
+    return cache;
+}
+
+void pico_audio_mem_written(pico_audio_t* audio, uint16_t addr, uint16_t len) {
+    const uint32_t base = offsetof(pico_ram_t, sfx);
+    uint32_t end = (uint32_t)addr + len;
+    if (end <= base || addr >= base + sizeof(audio->ram->sfx)) return;
+    
+    uint32_t first = addr > base ? (addr - base) / sizeof(pico_sfx_t) : 0;
+    for (uint32_t i = first; i < PICO_SFX_COUNT && base + i * sizeof(pico_sfx_t) < end; i++) {
+        audio->sfx_cache[i].valid = false;
+    }
+}
+
+// Channels
+
+static void channel_start(pico_audio_t* audio, pico_channel_t* ch, uint8_t n,
+                          uint8_t offset, uint8_t length, bool music);
+
+static void channel_decode_note(pico_audio_t* audio, pico_channel_t* ch) {
+    const pico_note_decoded_t* d = &sfx_decoded(audio, ch->sfx_index)->notes[ch->note_index];
+    ch->waveform = d->waveform & 7;
+    ch->volume = d->volume;
+    ch->effect = d->effect;
+    
+    // Instruments can't nest; their custom bit is ignored
+    bool custom = !ch->instrument && (d->waveform & PICO_NOTE_CUSTOM);
+    
+    ch->base_frequency = pico_note_to_freq(d->key);
+    ch->frequency = ch->base_frequency;
+    ch->phase_inc = d->phase_inc;
+    
+    // Each custom note restarts its instrument, except a slide into the
+    // same instrument, which carries on with only the pitch moving
+    if (custom) {
+        pico_channel_t* v = &audio->voices[ch - audio->channels];
+        if (!(ch->custom && ch->effect == PICO_FX_SLIDE && v->sfx_index == ch->waveform)) {
+            channel_start(audio, v, ch->waveform, 0, PICO_NOTES_PER_SFX, false);
+        }
+    }
+    ch->custom = custom;
+}
+
+static void channel_start(pico_audio_t* audio, pico_channel_t* ch, uint8_t n,
+                          uint8_t offset, uint8_t length, bool music) {
+    pico_sfx_t* sfx = &audio->ram->sfx[n];
+    
+    uint32_t end = sfx_length(sfx);
+    if ((uint32_t)offset + length < end) end = offset + length;
+    if (offset >= end) {
+        ch->sfx_index = -1;
+        ch->music = false;
+        return;
+    }
+    
+    bool was_idle = ch->sfx_index < 0;
+    ch->custom = false;
+    ch->sfx_index = n;
+    ch->note_index = offset;
+    ch->note_end = (uint8_t)end;
+    ch->music = music;
+    ch->sample_counter = 0;
+    ch->sfx_samples = 0;
+    ch->phase = 0;
+    ch->samples_per_tick = sfx_decoded(audio, n)->samples_per_tick;
+    channel_decode_note(audio, ch);
+    
+    // A slide on the first note starts from the previous sfx, if any
+    if (was_idle) {
+        ch->prev_phase_inc = ch->phase_inc;
+        ch->prev_volume = ch->volume;
+    }
+}
+
+// Called when a channel's tick counter runs out
+static void channel_next_note(pico_audio_t* audio, pico_channel_t* ch) {
+    ch->sample_counter = 0;
+    
+    pico_sfx_t* sfx = &audio->ram->sfx[ch->sfx_index];
+    ch->prev_phase_inc = ch->phase_inc;
+    ch->prev_volume = ch->volume;
+    ch->note_index++;
+    if (sfx_loops(sfx) && ch->note_index >= sfx->loop_end) {
+        ch->note_index = sfx->loop_start;
+    } else if (ch->note_index >= ch->note_end) {
+        ch->sfx_index = -1;
+        ch->music = false;
+        return;
+    }
+    
+    ch->phase = 0;
+    channel_decode_note(audio, ch);
 }
 
 void pico_sfx(pico_audio_t* audio, int8_t n, int8_t channel, 
@@ -128,6 +232,7 @@ void pico_sfx(pico_audio_t* audio, int8_t n, int8_t channel,
     if (n < 0) {
         if (channel >= 0 && channel < PICO_CHANNELS) {
             audio->channels[channel].sfx_index = -1;
+            audio->channels[channel].music = false;
         }
         return;
     }
@@ -135,111 +240,677 @@ void pico_sfx(pico_audio_t* audio, int8_t n, int8_t channel,
     if (n >= PICO_SFX_COUNT) return;
     
     if (channel < 0) {
+        // Channels reserved by music() are only used when asked for by index
+        uint8_t reserved = audio->music.pattern_index >= 0 ? audio->music.channel_mask : 0;
         for (int i = 0; i < PICO_CHANNELS; i++) {
-            if (audio->channels[i].sfx_index < 0) {
+            if (audio->channels[i].sfx_index < 0 && !(reserved & (1 << i))) {
                 channel = i;
                 break;
             }
         }
+        if (channel < 0) {
+            for (int i = 0; i < PICO_CHANNELS; i++) {
+                if (!(reserved & (1 << i))) {
+                    channel = i;
+                    break;
+                }
+            }
+        }
         if (channel < 0) channel = 0;
     }
     
     if (channel >= PICO_CHANNELS) return;
     
-    pico_channel_t* ch = &audio->channels[channel];
-    pico_sfx_t* sfx = &audio->ram->sfx[n];
+    channel_start(audio, &audio->channels[channel], n, offset, length, false);
+}
+
+// Music Sequencer
+
+static void music_stop(pico_audio_t* audio) {
+    for (int c = 0; c < PICO_CHANNELS; c++) {
+        pico_channel_t* ch = &audio->channels[c];
+        if (ch->music) {
+            ch->sfx_index = -1;
+            ch->music = false;
+        }
+    }
+    audio->music.pattern_index = -1;
+    audio->music.samples_left = 0;
+    audio->music.fade_left = 0;
+    audio->music.gain = MUSIC_GAIN_ONE;
+}
+
+// Starts every enabled channel of pattern n that isn't busy with a plain
+// sfx. The pattern lasts as long as its leftmost non-looping channel (or
+// the leftmost channel if all of them loop). Returns false for an empty
+// pattern, which ends the song.
+static bool music_start_pattern(pico_audio_t* audio, int n) {
+    const pico_song_t* song = &audio->ram->songs[n];
+    pico_music_state_t* m = &audio->music;
     
-    ch->sfx_index = n;
-    ch->note_index = offset;
-    ch->sample_counter = 0;
-    ch->phase = 0;
+    int timing = -1;
+    const pico_sfx_t* timing_sfx = NULL;
+    for (int c = 0; c < PICO_CHANNELS; c++) {
+        if (song->data[c] & 0x40) continue;
+        const pico_sfx_t* sfx = &audio->ram->sfx[song->data[c] & 0x3F];
+        if (timing < 0 || (sfx_loops(timing_sfx) && !sfx_loops(sfx))) {
+            timing = c;
+            timing_sfx = sfx;
+        }
+    }
+    if (timing < 0) return false;
     
-    uint32_t speed = sfx->speed;
-    if (speed == 0) speed = 1;
-    ch->samples_per_tick = (PICO_SAMPLE_RATE * speed) / 120;
+    for (int c = 0; c < PICO_CHANNELS; c++) {
+        pico_channel_t* ch = &audio->channels[c];
+        if (ch->music) {
+            ch->sfx_index = -1;
+            ch->music = false;
+        }
+        if (song->data[c] & 0x40) continue;
+        if (m->channel_mask && !(m->channel_mask & (1 << c))) continue;
+        if (ch->sfx_index >= 0) continue;
+        channel_start(audio, ch, song->data[c] & 0x3F, 0, PICO_NOTES_PER_SFX, true);
+    }
+    
+    m->pattern_index = (int8_t)n;
+    m->tick_samples = sfx_samples_per_tick(timing_sfx);
+    m->pattern_samples = sfx_length(timing_sfx) * m->tick_samples;
+    m->samples_left = m->pattern_samples;
+    return true;
+}
+
+static void music_next_pattern(pico_audio_t* audio) {
+    int n = audio->music.pattern_index;
+    const pico_song_t* song = &audio->ram->songs[n];
+    
+    int next;
+    if (pico_song_stop(song)) {
+        next = -1;
+    } else if (pico_song_loop(song)) {
+        next = n;
+        while (next > 0 && !pico_song_start(&audio->ram->songs[next])) next--;
+    } else {
+        next = n + 1 < PICO_MUSIC_COUNT ? n + 1 : -1;
+    }
+    
+    if (next < 0 || !music_start_pattern(audio, next)) {
+        music_stop(audio);
+        return;
+    }
+    audio->music.patterns_played++;
+}
+
+static uint32_t ms_to_samples(uint16_t ms) {
+    return ((uint32_t)ms * PICO_SAMPLE_RATE) / 1000;
 }
 
 void pico_music(pico_audio_t* audio, int8_t n, uint16_t fade_ms, 
                 uint8_t channel_mask) {
+    pico_music_state_t* m = &audio->music;
+    
     if (n < 0) {
-        audio->music.pattern_index = -1;
+        uint32_t fade = ms_to_samples(fade_ms);
+        if (m->pattern_index >= 0 && fade > 0) {
+            fade_start(m, m->gain, 0, fade);
+        } else {
+            music_stop(audio);
+        }
         return;
     }
     
     if (n >= PICO_MUSIC_COUNT) return;
     
-    audio->music.pattern_index = n;
-    audio->music.tick = 0;
-    audio->music.loop_enabled = true;
+    music_stop(audio);
+    m->channel_mask = channel_mask & 0x0F;
+    m->patterns_played = 0;
+    
+    uint32_t fade = ms_to_samples(fade_ms);
+    if (fade > 0) {
+        fade_start(m, 0, MUSIC_GAIN_ONE, fade);
+    }
     
-    (void)fade_ms;
-    (void)channel_mask;
+    if (!music_start_pattern(audio, n)) {
+        music_stop(audio);
+    }
 }
 
-static void update_channel(pico_audio_t* audio, pico_channel_t* ch) {
-    if (ch->sfx_index < 0) return;
+// Mixing
+
+// Adds n samples of a channel's current note into mix. Level (volume
+// times music gain) and phase increment ramp linearly across the run, so
+// each sample is a lookup, a multiply and a few adds.
+static void render_run(pico_channel_t* ch, int32_t* mix, uint32_t n,
+                       int32_t level, int32_t level_step,
+                       uint32_t inc, int32_t inc_step) {
+    if (ch->waveform == PICO_WAVE_NOISE) {
+        uint16_t lfsr = ch->noise_lfsr;
+        for (uint32_t i = 0; i < n; i++) {
+            mix[i] += (noise_next(&lfsr) * (level >> 8)) >> 16;
+            level += level_step;
+        }
+        ch->noise_lfsr = lfsr;
+        ch->phase += inc * n;
+        return;
+    }
     
-    pico_sfx_t* sfx = &audio->ram->sfx[ch->sfx_index];
+    const int16_t* table = pico_wavetables.wave[ch->waveform & 7];
+    uint32_t phase = ch->phase;
+    for (uint32_t i = 0; i < n; i++) {
+        mix[i] += (table[phase >> WAVETABLE_SHIFT] * (level >> 8)) >> 16;
+        level += level_step;
+        phase += inc;
+        inc += inc_step;
+    }
+    ch->phase = phase;
+}
+
+// Effects
+
+#define FX_CONTROL_SAMPLES  64          // Effect update interval (~345Hz)
+#define FX_SEMITONE_16      3897        // (2^(1/12) - 1) in 16.16
+#define FX_VIBRATO_RATE     491520      // 7.5Hz in 16.16
+
+typedef struct {
+    uint32_t inc;                       // Phase increment
+    int32_t amp;                        // Volume * 32
+} fx_point_t;
+
+// Pitch and amplitude of a channel 'counter' samples into its note and
+// 'sfx_time' samples into its sfx
+static fx_point_t fx_eval(pico_audio_t* audio, const pico_channel_t* ch,
+                          uint32_t counter, uint32_t sfx_time) {
+    fx_point_t p = {ch->phase_inc, ch->volume * 32};
     
-    ch->sample_counter++;
-    if (ch->sample_counter >= ch->samples_per_tick) {
-        ch->sample_counter = 0;
-        ch->note_index++;
+    // Progress through the note, 0..65536
+    uint32_t t = (uint32_t)(((uint64_t)counter << 16) / ch->samples_per_tick);
+    
+    switch (ch->effect) {
+        case PICO_FX_SLIDE:
+            p.inc = ch->prev_phase_inc +
+                    (int32_t)(((int64_t)((int32_t)(ch->phase_inc - ch->prev_phase_inc)) * t) >> 16);
+            if (ch->prev_volume > 0) {
+                int32_t from = ch->prev_volume * 32;
+                p.amp = from + (((p.amp - from) * (int32_t)t) >> 16);
+            }
+            break;
+            
+        case PICO_FX_VIBRATO: {
+            // Triangle LFO, +-1/4 semitone
+            uint32_t v = (uint32_t)(((uint64_t)sfx_time * FX_VIBRATO_RATE) / PICO_SAMPLE_RATE) & 0xFFFF;
+            int32_t tri = abs((int32_t)v - 0x8000) - 0x4000;
+            p.inc += (int32_t)(((int64_t)p.inc * FX_SEMITONE_16 * tri) >> 32);
+            break;
+        }
+            
+        case PICO_FX_DROP:
+            p.inc = (uint32_t)(((uint64_t)p.inc * (65536 - t)) >> 16);
+            break;
+            
+        case PICO_FX_FADE_IN:
+            p.amp = (p.amp * (int32_t)t) >> 16;
+            break;
+            
+        case PICO_FX_FADE_OUT:
+            p.amp = (p.amp * (int32_t)(65536 - t)) >> 16;
+            break;
+            
+        case PICO_FX_ARPFAST:
+        case PICO_FX_ARPSLOW: {
+            // Cycle the 4-note group at 7.5 * m steps per second
+            const pico_sfx_t* sfx = &audio->ram->sfx[ch->sfx_index];
+            int m = (sfx->speed <= 8 ? 32 : 16) / (ch->effect == PICO_FX_ARPFAST ? 4 : 8);
+            uint32_t step = (uint32_t)(((uint64_t)sfx_time * m * 15) / (2 * PICO_SAMPLE_RATE));
+            uint8_t note = (ch->note_index & ~3) | (step & 3);
+            p.inc = sfx_decoded(audio, ch->sfx_index)->notes[note].phase_inc;
+            break;
+        }
+            
+        default:
+            break;
+    }
+    return p;
+}
+
+// Renders a run with pitch and volume interpolated between two points
+static void render_points(pico_channel_t* ch, int32_t* mix, uint32_t n,
+                          fx_point_t a, fx_point_t b, int32_t gain0, int32_t gain1) {
+    if (a.amp > 0 || b.amp > 0) {
+        int32_t level0 = a.amp * gain0;
+        int32_t level1 = b.amp * gain1;
+        render_run(ch, mix, n, level0, (level1 - level0) / (int32_t)n,
+                   a.inc, (int32_t)(b.inc - a.inc) / (int32_t)n);
+    } else {
+        ch->phase += a.inc * n;
+    }
+}
+
+// Effect end points of a voice's next run
+static uint32_t voice_points(pico_audio_t* audio, pico_channel_t* v, uint32_t run,
+                             fx_point_t* a, fx_point_t* b) {
+    if (run > FX_CONTROL_SAMPLES) run = FX_CONTROL_SAMPLES;
+    *a = fx_eval(audio, v, v->sample_counter, v->sfx_samples);
+    *b = fx_eval(audio, v, v->sample_counter + run, v->sfx_samples + run);
+    
+    // Arpeggio notes change in steps; don't glide between them
+    if (v->effect >= PICO_FX_ARPFAST) b->inc = a->inc;
+    return run;
+}
+
+static void voice_advance(pico_audio_t* audio, pico_channel_t* v, uint32_t run) {
+    v->sfx_samples += run;
+    v->sample_counter += run;
+    if (v->sample_counter >= v->samples_per_tick) {
+        channel_next_note(audio, v);
+    }
+}
+
+// Parent note modulation at pos of n: pitch is relative to C-2 (key 24),
+// volume scales the instrument's own
+static inline fx_point_t fx_lerp(fx_point_t a, fx_point_t b, uint32_t pos, uint32_t n) {
+    fx_point_t p;
+    p.inc = a.inc + (int32_t)((int64_t)(int32_t)(b.inc - a.inc) * pos / n);
+    p.amp = a.amp + (b.amp - a.amp) * (int32_t)pos / (int32_t)n;
+    return p;
+}
+
+static inline fx_point_t fx_apply(fx_point_t inst, fx_point_t parent) {
+    fx_point_t p;
+    p.inc = (uint32_t)(((uint64_t)inst.inc * parent.inc) / pico_note_tables.phase_inc[24]);
+    p.amp = inst.amp * parent.amp / (7 * 32);
+    return p;
+}
+
+// Renders n samples of a custom note: the channel's instrument sub-voice
+// on its own tick clock, modulated by the parent note's points pa..pb
+static void render_instrument(pico_audio_t* audio, pico_channel_t* ch, int32_t* mix,
+                              uint32_t n, fx_point_t pa, fx_point_t pb,
+                              int32_t gain, int32_t step) {
+    pico_channel_t* v = &audio->voices[ch - audio->channels];
+    uint32_t pos = 0;
+    while (pos < n && v->sfx_index >= 0) {
+        uint32_t run = v->samples_per_tick - v->sample_counter;
+        if (run > n - pos) run = n - pos;
+        
+        fx_point_t a, b;
+        run = voice_points(audio, v, run, &a, &b);
+        a = fx_apply(a, fx_lerp(pa, pb, pos, n));
+        b = fx_apply(b, fx_lerp(pa, pb, pos + run, n));
+        render_points(v, mix + pos, run, a, b,
+                      gain + step * (int32_t)pos, gain + step * (int32_t)(pos + run));
+        
+        pos += run;
+        voice_advance(audio, v, run);
+    }
+}
+
+// Renders one channel into mix in runs that end on tick boundaries, so
+// notes are decoded once per tick. Notes with an effect or instrument are
+// further cut into FX_CONTROL_SAMPLES runs with parameters interpolated
+// between the run's end points. Silent runs only advance the clock.
+static void render_channel(pico_audio_t* audio, pico_channel_t* ch,
+                           int32_t* mix, uint32_t n, int32_t gain, int32_t step) {
+    uint32_t pos = 0;
+    while (pos < n && ch->sfx_index >= 0) {
+        uint32_t run = ch->samples_per_tick - ch->sample_counter;
+        if (run > n - pos) run = n - pos;
+        int32_t gain1 = gain + step * (int32_t)run;
         
-        if (ch->note_index >= PICO_NOTES_PER_SFX) {
-            if (sfx->loop_start < sfx->loop_end) {
-                ch->note_index = sfx->loop_start;
+        if (ch->effect == PICO_FX_NONE && !ch->custom) {
+            int32_t amp = ch->volume * 32;
+            if (amp > 0) {
+                render_run(ch, mix + pos, run, amp * gain, amp * step, ch->phase_inc, 0);
             } else {
-                ch->sfx_index = -1;
-                return;
+                ch->phase += ch->phase_inc * run;
+            }
+        } else {
+            fx_point_t a, b;
+            run = voice_points(audio, ch, run, &a, &b);
+            gain1 = gain + step * (int32_t)run;
+            if (ch->custom) {
+                render_instrument(audio, ch, mix + pos, run, a, b, gain, step);
+            } else {
+                render_points(ch, mix + pos, run, a, b, gain, gain1);
             }
         }
-        
-        ch->phase = 0;
+        gain = gain1;
+        pos += run;
+        voice_advance(audio, ch, run);
     }
+}
+
+// Filters
+
+#define LOWPASS_COEF    22817   // 1 - exp(-2pi * 1500 / 22050), 16.16
+
+static void filters_update(pico_audio_t* audio) {
+    const pico_hw_state_t* hw = &audio->ram->hw;
+#if PICO_ENABLE_REVERB
+    // Start from silence rather than a stale tail
+    if (!(audio->filter_regs[0] & 0x0F) && (hw->reverb & 0x0F)) {
+        memset(&audio->reverb, 0, sizeof(pico_reverb_t));
+    }
+#endif
+    audio->filter_regs[0] = hw->reverb;
+    audio->filter_regs[1] = hw->distort;
+    audio->filter_regs[2] = hw->lowpass;
     
-    pico_note_t* note = &sfx->notes[ch->note_index];
+    for (int c = 0; c < PICO_CHANNELS; c++) {
+        pico_channel_filter_t* f = &audio->filters[c];
+        f->reverb = PICO_ENABLE_REVERB && ((hw->reverb >> c) & 1);
+        f->distort = (hw->distort >> c) & 1;
+        bool lowpass = (hw->lowpass >> c) & 1;
+        if (lowpass && !f->lowpass) f->lp_state = 0;
+        f->lowpass = lowpass;
+        f->lp_coef = lowpass ? LOWPASS_COEF : 0;
+    }
+}
+
+static void filter_block(pico_channel_filter_t* f, int32_t* buf, uint32_t n) {
+    if (f->distort) {
+        const int16_t* curve = pico_distort_table.curve;
+        for (uint32_t i = 0; i < n; i++) {
+            int32_t x = buf[i];
+            if (x > 16383) x = 16383;
+            if (x < -16384) x = -16384;
+            x += 16384;
+            int32_t a = curve[x >> 7];
+            int32_t b = curve[(x >> 7) + 1];
+            buf[i] = a + (((b - a) * (x & 127)) >> 7);
+        }
+    }
+    if (f->lowpass) {
+        int32_t y = f->lp_state;
+        for (uint32_t i = 0; i < n; i++) {
+            y += ((buf[i] - y) * f->lp_coef) >> 16;
+            buf[i] = y;
+        }
+        f->lp_state = y;
+    }
+}
+
+#if PICO_ENABLE_REVERB
+
+#define REVERB_FEEDBACK 49152   // 0.75, 16.16
+#define REVERB_DAMP     32768   // Comb feedback lowpass, 16.16
+#define REVERB_WET      24576   // 0.375, 16.16
+
+static inline int16_t clamp16(int32_t v) {
+    return v > 32767 ? 32767 : (v < -32768 ? -32768 : (int16_t)v);
+}
+
+static inline int32_t comb_tick(int16_t* line, uint16_t* pos, uint16_t len,
+                                int32_t* damp, int32_t x) {
+    int32_t y = line[*pos];
+    *damp += ((y - *damp) * REVERB_DAMP) >> 16;
+    line[*pos] = clamp16(x + ((*damp * REVERB_FEEDBACK) >> 16));
+    if (++*pos == len) *pos = 0;
+    return y;
+}
+
+// Gain 1/2 allpass
+static inline int32_t allpass_tick(int16_t* line, uint16_t* pos, uint16_t len, int32_t x) {
+    int32_t d = line[*pos];
+    int32_t v = x + (d >> 1);
+    line[*pos] = clamp16(v);
+    if (++*pos == len) *pos = 0;
+    return d - (v >> 1);
+}
+
+static int32_t reverb_tick(pico_reverb_t* rv, int32_t x) {
+    x >>= 2;
+    int32_t y = comb_tick(rv->comb1, &rv->pos_c1, PICO_REVERB_COMB1, &rv->damp1, x) +
+                comb_tick(rv->comb2, &rv->pos_c2, PICO_REVERB_COMB2, &rv->damp2, x);
+    y = allpass_tick(rv->ap1, &rv->pos_a1, PICO_REVERB_AP1, y);
+    return allpass_tick(rv->ap2, &rv->pos_a2, PICO_REVERB_AP2, y);
+}
+
+// Averages send pairs down to half rate and adds the wet signal back,
+// interpolated, at full rate
+static void reverb_block(pico_reverb_t* rv, int32_t* mix, uint32_t n) {
+    for (uint32_t i = 0; i < n; i++) {
+        rv->acc += rv->send[i];
+        int32_t out;
+        if (rv->half) {
+            rv->prev_wet = rv->wet;
+            rv->wet = reverb_tick(rv, rv->acc >> 1);
+            rv->acc = 0;
+            out = rv->prev_wet;
+        } else {
+            out = (rv->prev_wet + rv->wet) >> 1;
+        }
+        rv->half = !rv->half;
+        mix[i] += (out * REVERB_WET) >> 16;
+    }
+}
+
+#endif
+
+// PCM Stream
+// serial(0x808) bytes play at a quarter of the synth rate, interpolated
+// linearly between samples. Lua and the mixer share the emulator thread.
+
+#define PCM_LEVEL_SHIFT 7               // Full scale at half the int16 range
+
+uint32_t pico_audio_pcm_write(pico_audio_t* audio, const uint8_t* data, uint32_t len) {
+    pico_pcm_stream_t* pcm = &audio->pcm;
+    uint32_t space = PICO_AUDIO_PCM_STREAM_SIZE - (pcm->head - pcm->tail);
+    if (len > space) len = space;
+    for (uint32_t i = 0; i < len; i++) {
+        pcm->data[(pcm->head + i) & (PICO_AUDIO_PCM_STREAM_SIZE - 1)] = data[i];
+    }
+    pcm->head += len;
+    return len;
+}
+
+uint32_t pico_audio_pcm_queued(const pico_audio_t* audio) {
+    return audio->pcm.head - audio->pcm.tail;
+}
+
+static void pcm_block(pico_audio_t* audio, int32_t* mix, uint32_t n) {
+    pico_pcm_stream_t* pcm = &audio->pcm;
+    int32_t volume = audio->master_volume;
     
-    uint8_t pitch = pico_note_key(note);
-    ch->waveform = pico_note_waveform(note);
-    ch->volume = pico_note_volume(note);
-    ch->effect = pico_note_effect(note);
+    for (uint32_t i = 0; i < n; i++) {
+        if (pcm->phase == 0) {
+            // Fetch the next target; an empty stream settles to silence
+            pcm->prev = pcm->next;
+            pcm->next = 0;
+            if (pcm->head != pcm->tail) {
+                uint8_t b = pcm->data[pcm->tail & (PICO_AUDIO_PCM_STREAM_SIZE - 1)];
+                pcm->next = ((int32_t)b - 128) << PCM_LEVEL_SHIFT;
+                pcm->tail++;
+            }
+        }
+        int32_t v = pcm->prev + (((pcm->next - pcm->prev) * pcm->phase) >> 2);
+        mix[i] += (v * volume) >> 8;
+        pcm->phase = (pcm->phase + 1) & (PICO_PCM_RATE_DIV - 1);
+    }
+}
+
+// Sequencer Snapshot
+
+static void status_publish(pico_audio_t* audio, uint32_t pattern_pos) {
+    const pico_music_state_t* m = &audio->music;
+    pico_audio_status_t* st = &audio->status;
+    uint32_t seq = audio->status_seq;
     
-    ch->base_frequency = pico_note_to_freq(pitch);
-    ch->frequency = ch->base_frequency;
-    ch->phase_inc = (ch->frequency * 65536) / PICO_SAMPLE_RATE;
+    __atomic_store_n(&audio->status_seq, seq + 1, __ATOMIC_RELAXED);
+    __atomic_thread_fence(__ATOMIC_RELEASE);
+    for (int c = 0; c < PICO_CHANNELS; c++) {
+        const pico_channel_t* ch = &audio->channels[c];
+        st->sfx[c] = ch->sfx_index;
+        st->note[c] = ch->sfx_index >= 0 ? (int8_t)ch->note_index : -1;
+    }
+    st->pattern = m->pattern_index;
+    st->patterns_played = m->patterns_played;
+    st->ticks = m->pattern_index >= 0 && m->tick_samples ? (uint16_t)(pattern_pos / m->tick_samples) : 0;
+    __atomic_store_n(&audio->status_seq, seq + 2, __ATOMIC_RELEASE);
 }
 
-void pico_audio_fill(pico_audio_t* audio, int16_t* out, uint16_t samples) {
-    for (uint16_t i = 0; i < samples; i++) {
-        int32_t mix = 0;
+void pico_audio_get_status(const pico_audio_t* audio, pico_audio_status_t* status) {
+    uint32_t seq;
+    do {
+        seq = __atomic_load_n(&audio->status_seq, __ATOMIC_ACQUIRE);
+        memcpy(status, &audio->status, sizeof(pico_audio_status_t));
+        __atomic_thread_fence(__ATOMIC_ACQUIRE);
+    } while ((seq & 1) || seq != __atomic_load_n(&audio->status_seq, __ATOMIC_RELAXED));
+}
+
+// Output Packing
+// Channels accumulate in int32 lanes, which four int16-range voices cannot
+// overflow; each block saturates once, straight into the device format.
+
+static inline int32_t sat16(int32_t v) {
+    // Out of range exactly when the top 17 bits disagree
+    if ((uint32_t)(v + 0x8000) > 0xFFFF) v = (v >> 31) ^ 0x7FFF;
+    return v;
+}
+
+static const uint8_t pcm_frame_bytes[] = {
+    [PICO_PCM_S16_MONO] = 2,
+    [PICO_PCM_S16_STEREO] = 4,
+    [PICO_PCM_U8] = 1,
+};
+
+static void pack_block(const int32_t* mix, uint8_t* out, uint32_t n, pico_pcm_format_t format) {
+    switch (format) {
+        case PICO_PCM_S16_MONO: {
+            int16_t* o = (int16_t*)out;
+            for (uint32_t i = 0; i < n; i++) o[i] = (int16_t)sat16(mix[i]);
+            break;
+        }
+        case PICO_PCM_S16_STEREO: {
+            // Both halves of a frame in one 32-bit store
+            for (uint32_t i = 0; i < n; i++) {
+                uint32_t s = (uint16_t)sat16(mix[i]);
+                uint32_t frame = s | (s << 16);
+                memcpy(out + i * 4, &frame, 4);
+            }
+            break;
+        }
+        case PICO_PCM_U8:
+            for (uint32_t i = 0; i < n; i++) out[i] = (uint8_t)((sat16(mix[i]) >> 8) + 128);
+            break;
+    }
+}
+
+// Master volume (0-255) folded into a 16.16 gain, so it costs one multiply
+// per channel per block instead of one per sample
+static inline int32_t apply_volume(int32_t gain, int32_t volume) {
+    return (int32_t)(((int64_t)gain * volume) >> 8);
+}
+
+// Renders n samples with no sequencer events inside the span, so music
+// gain is a plain linear ramp per channel
+static void mix_segment(pico_audio_t* audio, uint8_t* out, uint32_t n, pico_pcm_format_t format) {
+    const pico_music_state_t* m = &audio->music;
+    int32_t mix[PICO_AUDIO_BLOCK];
+    int32_t volume = audio->master_volume;
+    uint32_t frame_bytes = pcm_frame_bytes[format];
+    
+    const pico_hw_state_t* hw = &audio->ram->hw;
+    if (hw->reverb != audio->filter_regs[0] || hw->distort != audio->filter_regs[1] ||
+        hw->lowpass != audio->filter_regs[2]) {
+        filters_update(audio);
+    }
+#if PICO_ENABLE_REVERB
+    bool reverb = audio->filter_regs[0] & 0x0F;
+#endif
+    
+    for (uint32_t done = 0; done < n; ) {
+        uint32_t len = n - done;
+        if (len > PICO_AUDIO_BLOCK) len = PICO_AUDIO_BLOCK;
+        memset(mix, 0, len * sizeof(int32_t));
+#if PICO_ENABLE_REVERB
+        if (reverb) memset(audio->reverb.send, 0, len * sizeof(int16_t));
+#endif
         
         for (int c = 0; c < PICO_CHANNELS; c++) {
             pico_channel_t* ch = &audio->channels[c];
-            
             if (ch->sfx_index < 0) continue;
             
-            update_channel(audio, ch);
-            
-            if (ch->sfx_index < 0) continue;
-            
-            int16_t sample = pico_wave_sample(ch->waveform, ch->phase, &ch->noise_lfsr);
-            sample = (sample * ch->volume * 32) / 256;
-            ch->phase += ch->phase_inc;
+            // Scale the block's end points, not the step, so a fade's
+            // rounding never accumulates across blocks
+            int32_t gain = apply_volume(MUSIC_GAIN_ONE, volume);
+            int32_t step = 0;
+            if (ch->music) {
+                int32_t start = m->gain, end = m->gain;
+                if (m->fade_left > 0) {
+                    start = fade_gain(m, m->fade_left - done);
+                    end = fade_gain(m, m->fade_left - done - len);
+                }
+                gain = apply_volume(start, volume);
+                step = (apply_volume(end, volume) - gain) / (int32_t)len;
+            }
             
-            mix += sample;
+            // Filtered channels render apart, then join the mix
+            pico_channel_filter_t* f = &audio->filters[c];
+            if (f->distort || f->lowpass || f->reverb) {
+                int32_t* buf = audio->filter_buf;
+                memset(buf, 0, len * sizeof(int32_t));
+                render_channel(audio, ch, buf, len, gain, step);
+                filter_block(f, buf, len);
+                for (uint32_t i = 0; i < len; i++) mix[i] += buf[i];
+#if PICO_ENABLE_REVERB
+                if (f->reverb) {
+                    int16_t* send = audio->reverb.send;
+                    for (uint32_t i = 0; i < len; i++) send[i] = clamp16(send[i] + buf[i]);
+                }
+#endif
+            } else {
+                render_channel(audio, ch, mix, len, gain, step);
+            }
+        }
+#if PICO_ENABLE_REVERB
+        // Runs while enabled even with the channels silent, so tails decay
+        if (reverb) reverb_block(&audio->reverb, mix, len);
+#endif
+        // Dry, after the filters; runs on until the last sample has faded
+        if (audio->pcm.head != audio->pcm.tail || audio->pcm.next || audio->pcm.phase) {
+            pcm_block(audio, mix, len);
         }
         
-        if (mix > 32767) mix = 32767;
-        if (mix < -32768) mix = -32768;
-        
-        mix = (mix * audio->master_volume) / 256;
-        
-        out[i] = (int16_t)mix;
+        pack_block(mix, out + done * frame_bytes, len, format);
+        done += len;
+        status_publish(audio, m->pattern_samples - m->samples_left + done);
     }
 }
 
-void pico_audio_update(pico_audio_t* audio) {
-    if (audio->music.pattern_index < 0) return;
-    // TODO: Implement proper music sequencing
+void pico_audio_fill(pico_audio_t* audio, int16_t* out, uint16_t samples) {
+    pico_audio_fill_format(audio, out, samples, PICO_PCM_S16_MONO);
+}
+
+void pico_audio_fill_format(pico_audio_t* audio, void* out, uint16_t samples,
+                            pico_pcm_format_t format) {
+    pico_music_state_t* m = &audio->music;
+    uint8_t* dst = (uint8_t*)out;
+    uint32_t done = 0;
+    
+    while (done < samples) {
+        // Split the buffer at pattern ends and fade ends
+        uint32_t seg = samples - done;
+        if (m->pattern_index >= 0) {
+            if (m->samples_left < seg) seg = m->samples_left;
+            if (m->fade_left > 0 && m->fade_left < seg) seg = m->fade_left;
+        }
+        
+        mix_segment(audio, dst + done * pcm_frame_bytes[format], seg, format);
+        done += seg;
+        
+        if (m->pattern_index < 0) continue;
+        
+        if (m->fade_left > 0) {
+            m->fade_left -= seg;
+            m->gain = fade_gain(m, m->fade_left);
+            if (m->fade_left == 0 && m->fade_to == 0) {
+                music_stop(audio);
+                continue;
+            }
+        }
+        
+        m->samples_left -= seg;
+        if (m->samples_left == 0) {
+            music_next_pattern(audio);
+        }
+    }
 }
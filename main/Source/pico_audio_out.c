@@ -0,0 +1,311 @@
+// pico_audio_out.c
+// PCM output: lock-free ring between the emulator and an output thread
+//
+// The emulator renders into the ring from its frame loop and never waits
+// on the device. A dedicated thread drains the ring, converts it to the
+// device rate and hands it to a sink whose blocking write sets the pace;
+// if the ring runs dry it plays silence.
+
+#include "pico_audio_out.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#ifdef ESP_PLATFORM
+#include "driver/i2s_std.h"
+#endif
+
+#define PICO_DEBUG 1
+
+#if PICO_DEBUG
+#define PICO_LOG(fmt, ...) printf("[PICO] " fmt "\n", ##__VA_ARGS__)
+#else
+#define PICO_LOG(fmt, ...) ((void)0)
+#endif
+
+#define RING_MASK (PICO_AUDIO_RING_SIZE - 1)
+
+// PCM Ring
+
+void pico_pcm_ring_init(pico_pcm_ring_t* ring) {
+    memset(ring, 0, sizeof(pico_pcm_ring_t));
+}
+
+uint32_t pico_pcm_ring_readable(const pico_pcm_ring_t* ring) {
+    uint32_t head = __atomic_load_n(&ring->head, __ATOMIC_ACQUIRE);
+    uint32_t tail = __atomic_load_n(&ring->tail, __ATOMIC_ACQUIRE);
+    return head - tail;
+}
+
+uint32_t pico_pcm_ring_writable(const pico_pcm_ring_t* ring) {
+    return PICO_AUDIO_RING_SIZE - pico_pcm_ring_readable(ring);
+}
+
+int16_t* pico_pcm_ring_write_span(pico_pcm_ring_t* ring, uint32_t* n) {
+    uint32_t head = ring->head;
+    uint32_t space = PICO_AUDIO_RING_SIZE - (head - __atomic_load_n(&ring->tail, __ATOMIC_ACQUIRE));
+    uint32_t to_end = PICO_AUDIO_RING_SIZE - (head & RING_MASK);
+    *n = space < to_end ? space : to_end;
+    return &ring->data[head & RING_MASK];
+}
+
+void pico_pcm_ring_commit(pico_pcm_ring_t* ring, uint32_t n) {
+    __atomic_store_n(&ring->head, ring->head + n, __ATOMIC_RELEASE);
+}
+
+uint32_t pico_pcm_ring_write(pico_pcm_ring_t* ring, const int16_t* samples, uint32_t n) {
+    uint32_t done = 0;
+    while (done < n) {
+        uint32_t span;
+        int16_t* dst = pico_pcm_ring_write_span(ring, &span);
+        if (span == 0) {
+            __atomic_fetch_add(&ring->overruns, 1, __ATOMIC_RELAXED);
+            break;
+        }
+        if (span > n - done) span = n - done;
+        memcpy(dst, samples + done, span * sizeof(int16_t));
+        pico_pcm_ring_commit(ring, span);
+        done += span;
+    }
+    return done;
+}
+
+void pico_pcm_ring_read(pico_pcm_ring_t* ring, int16_t* out, uint32_t n) {
+    uint32_t tail = ring->tail;
+    uint32_t avail = __atomic_load_n(&ring->head, __ATOMIC_ACQUIRE) - tail;
+    uint32_t take = avail < n ? avail : n;
+
+    uint32_t first = PICO_AUDIO_RING_SIZE - (tail & RING_MASK);
+    if (first > take) first = take;
+    memcpy(out, &ring->data[tail & RING_MASK], first * sizeof(int16_t));
+    memcpy(out + first, ring->data, (take - first) * sizeof(int16_t));
+    __atomic_store_n(&ring->tail, tail + take, __ATOMIC_RELEASE);
+    __atomic_store_n(&ring->played, ring->played + n, __ATOMIC_RELEASE);
+
+    // Count each stretch of starvation once, not every silent block
+    if (take < n) {
+        memset(out + take, 0, (n - take) * sizeof(int16_t));
+        if (!ring->starved) {
+            __atomic_fetch_add(&ring->underruns, 1, __ATOMIC_RELAXED);
+        }
+        ring->starved = true;
+    } else {
+        ring->starved = false;
+    }
+}
+
+// File Sink
+
+typedef struct {
+    FILE* file;
+    struct timespec start;
+    uint64_t written;
+} file_sink_t;
+
+static bool file_sink_write(pico_audio_sink_t* sink, const int16_t* samples, uint32_t count) {
+    file_sink_t* fs = (file_sink_t*)sink->state;
+    if (fwrite(samples, sizeof(int16_t), count, fs->file) != count) return false;
+    fflush(fs->file);
+    fs->written += count;
+
+    // Regular files never block; sleep until the samples are "played"
+    uint64_t due_ns = fs->written * 1000000000ull / PICO_AUDIO_DEVICE_RATE;
+    struct timespec due = fs->start;
+    due.tv_sec += (time_t)(due_ns / 1000000000ull);
+    due.tv_nsec += (long)(due_ns % 1000000000ull);
+    if (due.tv_nsec >= 1000000000L) {
+        due.tv_sec++;
+        due.tv_nsec -= 1000000000L;
+    }
+    clock_nanosleep(CLOCK_MONOTONIC, TIMER_ABSTIME, &due, NULL);
+    return true;
+}
+
+static void file_sink_close(pico_audio_sink_t* sink) {
+    file_sink_t* fs = (file_sink_t*)sink->state;
+    fclose(fs->file);
+    free(fs);
+    sink->state = NULL;
+}
+
+bool pico_audio_sink_open_file(pico_audio_sink_t* sink, const char* path) {
+    if (!path) return false;
+    file_sink_t* fs = calloc(1, sizeof(file_sink_t));
+    if (!fs) return false;
+
+    // Opening a FIFO blocks until a reader attaches
+    fs->file = fopen(path, "wb");
+    if (!fs->file) {
+        PICO_LOG("audio: cannot open %s", path);
+        free(fs);
+        return false;
+    }
+    clock_gettime(CLOCK_MONOTONIC, &fs->start);
+
+    sink->write = file_sink_write;
+    sink->close = file_sink_close;
+    sink->state = fs;
+    return true;
+}
+
+// I2S Sink
+
+#ifdef ESP_PLATFORM
+
+static bool i2s_sink_write(pico_audio_sink_t* sink, const int16_t* samples, uint32_t count) {
+    size_t written = 0;
+    return i2s_channel_write((i2s_chan_handle_t)sink->state, samples,
+                             count * sizeof(int16_t), &written, portMAX_DELAY) == ESP_OK;
+}
+
+static void i2s_sink_close(pico_audio_sink_t* sink) {
+    i2s_chan_handle_t tx = (i2s_chan_handle_t)sink->state;
+    i2s_channel_disable(tx);
+    i2s_del_channel(tx);
+    sink->state = NULL;
+}
+
+bool pico_audio_sink_open_i2s(pico_audio_sink_t* sink) {
+    if (PICO_I2S_DOUT_GPIO < 0) return false;
+
+    i2s_chan_handle_t tx;
+    i2s_chan_config_t chan_cfg = I2S_CHANNEL_DEFAULT_CONFIG(I2S_NUM_AUTO, I2S_ROLE_MASTER);
+    if (i2s_new_channel(&chan_cfg, &tx, NULL) != ESP_OK) return false;
+
+    i2s_std_config_t std_cfg = {
+        .clk_cfg = I2S_STD_CLK_DEFAULT_CONFIG(PICO_AUDIO_DEVICE_RATE),
+        .slot_cfg = I2S_STD_PHILIPS_SLOT_DEFAULT_CONFIG(I2S_DATA_BIT_WIDTH_16BIT, I2S_SLOT_MODE_MONO),
+        .gpio_cfg = {
+            .mclk = I2S_GPIO_UNUSED,
+            .bclk = PICO_I2S_BCLK_GPIO,
+            .ws = PICO_I2S_WS_GPIO,
+            .dout = PICO_I2S_DOUT_GPIO,
+            .din = I2S_GPIO_UNUSED,
+        },
+    };
+    if (i2s_channel_init_std_mode(tx, &std_cfg) != ESP_OK ||
+        i2s_channel_enable(tx) != ESP_OK) {
+        PICO_LOG("audio: i2s init failed");
+        i2s_del_channel(tx);
+        return false;
+    }
+
+    sink->write = i2s_sink_write;
+    sink->close = i2s_sink_close;
+    sink->state = tx;
+    return true;
+}
+
+#else
+
+bool pico_audio_sink_open_i2s(pico_audio_sink_t* sink) {
+    (void)sink;
+    return false;
+}
+
+#endif
+
+// Output Thread
+
+static void* output_thread(void* arg) {
+    pico_audio_out_t* out = (pico_audio_out_t*)arg;
+    int16_t block[PICO_AUDIO_OUT_BLOCK];
+
+    while (__atomic_load_n(&out->running, __ATOMIC_ACQUIRE)) {
+#if PICO_AUDIO_DEVICE_RATE == PICO_SAMPLE_RATE
+        pico_pcm_ring_read(&out->ring, block, PICO_AUDIO_OUT_BLOCK);
+#else
+        int16_t* in = out->staging + PICO_RESAMPLE_TAPS;
+        uint32_t n_in = pico_resampler_input_for(&out->resampler, PICO_AUDIO_OUT_BLOCK);
+        pico_pcm_ring_read(&out->ring, in, n_in);
+        pico_resampler_process(&out->resampler, in, block, PICO_AUDIO_OUT_BLOCK);
+#endif
+        if (!out->sink.write(&out->sink, block, PICO_AUDIO_OUT_BLOCK)) {
+            PICO_LOG("audio: sink write failed, output stopped");
+            __atomic_store_n(&out->running, false, __ATOMIC_RELEASE);
+            break;
+        }
+    }
+    return NULL;
+}
+
+bool pico_audio_out_start(pico_audio_out_t* out, const pico_audio_sink_t* sink) {
+    pico_pcm_ring_init(&out->ring);
+    pico_resampler_init(&out->resampler, PICO_SAMPLE_RATE, PICO_AUDIO_DEVICE_RATE,
+                        PICO_AUDIO_RESAMPLE_FIR);
+    out->sink = *sink;
+    out->lead = PICO_AUDIO_CLOCK_PACING ? PICO_AUDIO_CLOCK_LEAD : PICO_AUDIO_LEAD;
+    pico_audio_out_clock_reset(out);
+    out->started = true;
+    out->running = true;
+
+    if (pthread_create(&out->thread, NULL, output_thread, out) != 0) {
+        out->started = false;
+        out->running = false;
+        out->sink.close(&out->sink);
+        return false;
+    }
+    return true;
+}
+
+void pico_audio_out_stop(pico_audio_out_t* out) {
+    if (!out->started) return;
+    out->started = false;
+    __atomic_store_n(&out->running, false, __ATOMIC_RELEASE);
+    pthread_join(out->thread, NULL);
+    out->sink.close(&out->sink);
+}
+
+bool pico_audio_out_running(const pico_audio_out_t* out) {
+    return __atomic_load_n(&out->running, __ATOMIC_ACQUIRE);
+}
+
+// Producer
+
+void pico_audio_out_pump(pico_audio_out_t* out, pico_audio_t* audio) {
+    if (!pico_audio_out_running(out)) return;
+
+    uint32_t queued = pico_pcm_ring_readable(&out->ring);
+    if (queued >= PICO_AUDIO_RING_SIZE) {
+        __atomic_fetch_add(&out->ring.overruns, 1, __ATOMIC_RELAXED);
+        return;
+    }
+
+    uint32_t want = queued < out->lead ? out->lead - queued : 0;
+    while (want > 0) {
+        uint32_t n;
+        int16_t* dst = pico_pcm_ring_write_span(&out->ring, &n);
+        if (n > want) n = want;
+        if (n == 0) break;
+        pico_audio_fill(audio, dst, (uint16_t)n);
+        pico_pcm_ring_commit(&out->ring, n);
+        want -= n;
+    }
+}
+
+// Audio Clock
+
+void pico_audio_out_clock_reset(pico_audio_out_t* out) {
+    out->clock_played = __atomic_load_n(&out->ring.played, __ATOMIC_ACQUIRE);
+    out->clock_samples = 0;
+    out->clock_frames = 0;
+}
+
+uint32_t pico_audio_out_frames_due(pico_audio_out_t* out, uint32_t fps) {
+    if (fps != out->clock_fps) {
+        pico_audio_out_clock_reset(out);
+        out->clock_fps = fps;
+    }
+    
+    uint32_t played = __atomic_load_n(&out->ring.played, __ATOMIC_ACQUIRE);
+    out->clock_samples += played - out->clock_played;
+    out->clock_played = played;
+    
+    // Exact for fractional frame lengths: frame k is due at k * rate / fps
+    uint64_t frames = out->clock_samples * fps / PICO_SAMPLE_RATE;
+    uint64_t due = frames - out->clock_frames;
+    if (due > PICO_AUDIO_CLOCK_MAX_FRAMES) due = PICO_AUDIO_CLOCK_MAX_FRAMES;
+    out->clock_frames = frames;
+    return (uint32_t)due;
+}
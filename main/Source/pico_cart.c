@@ -41,6 +41,123 @@ static cart_section_t identify_section(const char* line) {
     return SECTION_NONE;
 }
 
+// .p8 files store P8SCII glyphs as UTF-8; the lua section is decoded back to
+// single P8SCII bytes so control codes (e.g. \14 for the custom font) and the
+// 128-255 glyph range reach print() as PICO-8 sees them.
+// Entries left NULL are plain ASCII and copied as-is.
+static const char* const p8scii_utf8[256] = {
+    [0x01] = "¹", [0x02] = "²", [0x03] = "³", [0x04] = "⁴", [0x05] = "⁵",
+    [0x06] = "⁶", [0x07] = "⁷", [0x08] = "⁸", [0x0b] = "ᵇ", [0x0c] = "ᶜ",
+    [0x0e] = "ᵉ", [0x0f] = "ᶠ",
+    [0x10] = "▮", [0x11] = "■", [0x12] = "□", [0x13] = "⁙", [0x14] = "⁘",
+    [0x15] = "‖", [0x16] = "◀", [0x17] = "▶", [0x18] = "「", [0x19] = "」",
+    [0x1a] = "¥", [0x1b] = "•", [0x1c] = "、", [0x1d] = "。", [0x1e] = "゛",
+    [0x1f] = "゜", [0x7f] = "○",
+    [0x80] = "█", [0x81] = "▒", [0x82] = "🐱", [0x83] = "⬇", [0x84] = "░",
+    [0x85] = "✽", [0x86] = "●", [0x87] = "♥", [0x88] = "☉", [0x89] = "웃",
+    [0x8a] = "⌂", [0x8b] = "⬅", [0x8c] = "😐", [0x8d] = "♪", [0x8e] = "🅾",
+    [0x8f] = "◆", [0x90] = "…", [0x91] = "➡", [0x92] = "★", [0x93] = "⧗",
+    [0x94] = "⬆", [0x95] = "ˇ", [0x96] = "∧", [0x97] = "❎", [0x98] = "▤",
+    [0x99] = "▥",
+    [0x9a] = "あ", [0x9b] = "い", [0x9c] = "う", [0x9d] = "え", [0x9e] = "お",
+    [0x9f] = "か", [0xa0] = "き", [0xa1] = "く", [0xa2] = "け", [0xa3] = "こ",
+    [0xa4] = "さ", [0xa5] = "し", [0xa6] = "す", [0xa7] = "せ", [0xa8] = "そ",
+    [0xa9] = "た", [0xaa] = "ち", [0xab] = "つ", [0xac] = "て", [0xad] = "と",
+    [0xae] = "な", [0xaf] = "に", [0xb0] = "ぬ", [0xb1] = "ね", [0xb2] = "の",
+    [0xb3] = "は", [0xb4] = "ひ", [0xb5] = "ふ", [0xb6] = "へ", [0xb7] = "ほ",
+    [0xb8] = "ま", [0xb9] = "み", [0xba] = "む", [0xbb] = "め", [0xbc] = "も",
+    [0xbd] = "や", [0xbe] = "ゆ", [0xbf] = "よ", [0xc0] = "ら", [0xc1] = "り",
+    [0xc2] = "る", [0xc3] = "れ", [0xc4] = "ろ", [0xc5] = "わ", [0xc6] = "を",
+    [0xc7] = "ん", [0xc8] = "っ", [0xc9] = "ゃ", [0xca] = "ゅ", [0xcb] = "ょ",
+    [0xcc] = "ア", [0xcd] = "イ", [0xce] = "ウ", [0xcf] = "エ", [0xd0] = "オ",
+    [0xd1] = "カ", [0xd2] = "キ", [0xd3] = "ク", [0xd4] = "ケ", [0xd5] = "コ",
+    [0xd6] = "サ", [0xd7] = "シ", [0xd8] = "ス", [0xd9] = "セ", [0xda] = "ソ",
+    [0xdb] = "タ", [0xdc] = "チ", [0xdd] = "ツ", [0xde] = "テ", [0xdf] = "ト",
+    [0xe0] = "ナ", [0xe1] = "ニ", [0xe2] = "ヌ", [0xe3] = "ネ", [0xe4] = "ノ",
+    [0xe5] = "ハ", [0xe6] = "ヒ", [0xe7] = "フ", [0xe8] = "ヘ", [0xe9] = "ホ",
+    [0xea] = "マ", [0xeb] = "ミ", [0xec] = "ム", [0xed] = "メ", [0xee] = "モ",
+    [0xef] = "ヤ", [0xf0] = "ユ", [0xf1] = "ヨ", [0xf2] = "ラ", [0xf3] = "リ",
+    [0xf4] = "ル", [0xf5] = "レ", [0xf6] = "ロ", [0xf7] = "ワ", [0xf8] = "ヲ",
+    [0xf9] = "ン", [0xfa] = "ッ", [0xfb] = "ャ", [0xfc] = "ュ", [0xfd] = "ョ",
+    [0xfe] = "◜", [0xff] = "◝",
+};
+
+// Glyph lookup: P8SCII codes hashed by their UTF-8 sequence, whose length
+// comes from the lead byte. Every glyph is a single code point.
+#define GLYPH_SLOTS 512
+static uint8_t glyph_slots[GLYPH_SLOTS];    // 0 = empty
+static bool glyph_slots_built = false;
+
+static size_t utf8_length(uint8_t lead) {
+    if (lead >= 0xF0) return 4;
+    if (lead >= 0xE0) return 3;
+    if (lead >= 0xC0) return 2;
+    return 1;
+}
+
+static uint32_t glyph_hash(const char* s, size_t n) {
+    uint32_t key = 0;
+    for (size_t k = 0; k < n; k++) key = (key << 8) | (uint8_t)s[k];
+    return (key * 2654435761u) >> 23;
+}
+
+static void build_glyph_slots(void) {
+    for (int code = 1; code < 256; code++) {
+        const char* glyph = p8scii_utf8[code];
+        if (!glyph) continue;
+        uint32_t s = glyph_hash(glyph, strlen(glyph));
+        while (glyph_slots[s]) s = (s + 1) & (GLYPH_SLOTS - 1);
+        glyph_slots[s] = (uint8_t)code;
+    }
+    glyph_slots_built = true;
+}
+
+// P8SCII code for the glyph starting at src, with *used set to its length;
+// 0 if the bytes aren't one
+static uint8_t find_glyph(const char* src, size_t avail, size_t* used) {
+    size_t n = utf8_length((uint8_t)src[0]);
+    if (n > avail) return 0;
+    for (uint32_t s = glyph_hash(src, n); glyph_slots[s]; s = (s + 1) & (GLYPH_SLOTS - 1)) {
+        const char* glyph = p8scii_utf8[glyph_slots[s]];
+        if (strncmp(glyph, src, n) == 0 && glyph[n] == '\0') {
+            *used = n;
+            return glyph_slots[s];
+        }
+    }
+    return 0;
+}
+
+// Copies the lua section into lua_code, converting UTF-8 glyphs to P8SCII.
+// Returns the decoded length, or 0 if it does not fit.
+static size_t copy_lua_section(const char* src, size_t len, char* dst, size_t dst_size) {
+    if (!glyph_slots_built) build_glyph_slots();
+
+    size_t out = 0;
+    size_t i = 0;
+    while (i < len) {
+        if (out + 1 >= dst_size) {
+            dst[0] = '\0';
+            return 0;
+        }
+        uint8_t c = (uint8_t)src[i];
+        size_t used = 1;
+        if (c >= 0x80) {
+            uint8_t code = find_glyph(src + i, len - i, &used);
+            if (code) {
+                c = code;
+                // Emoji glyphs are usually followed by U+FE0F
+                if (i + used + 3 <= len && memcmp(src + i + used, "\xef\xb8\x8f", 3) == 0) {
+                    used += 3;
+                }
+            }
+        }
+        dst[out++] = (char)c;
+        i += used;
+    }
+    dst[out] = '\0';
+    return out;
+}
+
 void pico_cart_parse_gfx(const char* data, size_t len, pico_ram_t* ram) {
     int row = 0;
     const char* p = data;
@@ -144,14 +261,18 @@ void pico_cart_parse_sfx(const char* data, size_t len, pico_ram_t* ram) {
             sfx->loop_end = hex_to_byte(p); p += 2;
         }
         
+        // Notes are "PPWVE": pitch, waveform (8+ = custom), volume, effect
         for (int n = 0; n < 32 && p + 5 <= end; n++) {
-            uint8_t b0 = hex_to_byte(p);
-            uint8_t b1 = hex_char_to_nibble(p[2]);
-            uint8_t b2 = hex_char_to_nibble(p[3]);
-            uint8_t b3 = hex_char_to_nibble(p[4]);
+            uint8_t pitch = hex_to_byte(p);
+            uint8_t wave = hex_char_to_nibble(p[2]);
+            uint8_t vol = hex_char_to_nibble(p[3]);
+            uint8_t fx = hex_char_to_nibble(p[4]);
             
-            sfx->notes[n].data[0] = b0;
-            sfx->notes[n].data[1] = (b1 << 4) | (b2 << 1) | (b3 >> 2);
+            uint16_t bits = (pitch & 0x3F) | ((wave & 0x07) << 6) |
+                            ((vol & 0x07) << 9) | ((fx & 0x07) << 12) |
+                            ((wave & 0x08) << 12);
+            sfx->notes[n].data[0] = bits & 0xFF;
+            sfx->notes[n].data[1] = bits >> 8;
             
             p += 5;
         }
@@ -175,12 +296,14 @@ void pico_cart_parse_music(const char* data, size_t len, pico_ram_t* ram) {
         
         pico_song_t* song = &ram->songs[pattern_idx];
         
+        // "FF AABBCCDD": flag bit n moves into the MSB of channel byte n
         if (p + 10 <= end) {
-            song->data[0] = hex_to_byte(p); p += 2;
+            uint8_t flags = hex_to_byte(p); p += 2;
             if (*p == ' ') p++;
-            song->data[1] = hex_to_byte(p); p += 2;
-            song->data[2] = hex_to_byte(p); p += 2;
-            song->data[3] = hex_to_byte(p); p += 2;
+            for (int c = 0; c < 4; c++) {
+                song->data[c] = (hex_to_byte(p) & 0x7F) | (((flags >> c) & 1) << 7);
+                p += 2;
+            }
         }
         
         while (p < end && *p != '\n') p++;
@@ -233,11 +356,8 @@ int pico_cart_load_mem(const uint8_t* data, size_t len, pico_ram_t* ram,
                 
                 switch (current_section) {
                     case SECTION_LUA:
-                        if (section_len < lua_code_size) {
-                            memcpy(lua_code, section_start, section_len);
-                            lua_code[section_len] = '\0';
-                            lua_len = section_len;
-                        }
+                        lua_len = copy_lua_section(section_start, section_len,
+                                                   lua_code, lua_code_size);
                         break;
                     case SECTION_GFX:
                         pico_cart_parse_gfx(section_start, section_len, ram);
@@ -269,11 +389,8 @@ int pico_cart_load_mem(const uint8_t* data, size_t len, pico_ram_t* ram,
         
         switch (current_section) {
             case SECTION_LUA:
-                if (section_len < lua_code_size) {
-                    memcpy(lua_code, section_start, section_len);
-                    lua_code[section_len] = '\0';
-                    lua_len = section_len;
-                }
+                lua_len = copy_lua_section(section_start, section_len,
+                                           lua_code, lua_code_size);
                 break;
             case SECTION_GFX:
                 pico_cart_parse_gfx(section_start, section_len, ram);
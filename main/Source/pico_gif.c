@@ -0,0 +1,313 @@
+// pico_gif.c
+// Streaming animated GIF recorder
+//
+// Each frame only the bounding rectangle that changed since the previous
+// image is LZW-encoded. Output goes through a small chunk buffer so the
+// SD card sees fixed-size writes, and nothing larger than one frame copy
+// and the dictionary is held in memory.
+
+#include "pico_gif.h"
+#include <stdlib.h>
+#include <string.h>
+
+#define GIF_MIN_CODE_SIZE   4           // 16 colors
+#define GIF_CLEAR_CODE      (1 << GIF_MIN_CODE_SIZE)
+#define GIF_EOI_CODE        (GIF_CLEAR_CODE + 1)
+#define GIF_FIRST_CODE      (GIF_CLEAR_CODE + 2)
+#define GIF_MIN_DELAY_CS    2           // Viewers slow down anything shorter
+
+// Colors 0-15, then the extended colors 128-143
+static const uint8_t gif_palette[32][3] = {
+    {0x00, 0x00, 0x00}, {0x1D, 0x2B, 0x53}, {0x7E, 0x25, 0x53}, {0x00, 0x87, 0x51},
+    {0xAB, 0x52, 0x36}, {0x5F, 0x57, 0x4F}, {0xC2, 0xC3, 0xC7}, {0xFF, 0xF1, 0xE8},
+    {0xFF, 0x00, 0x4D}, {0xFF, 0xA3, 0x00}, {0xFF, 0xEC, 0x27}, {0x00, 0xE4, 0x36},
+    {0x29, 0xAD, 0xFF}, {0x83, 0x76, 0x9C}, {0xFF, 0x77, 0xA8}, {0xFF, 0xCC, 0xAA},
+    {0x29, 0x18, 0x14}, {0x11, 0x1D, 0x35}, {0x42, 0x21, 0x36}, {0x12, 0x53, 0x59},
+    {0x74, 0x2F, 0x29}, {0x49, 0x33, 0x3B}, {0xA2, 0x88, 0x79}, {0xF3, 0xEF, 0x7D},
+    {0xBE, 0x12, 0x50}, {0xFF, 0x6C, 0x24}, {0xA8, 0xE7, 0x2E}, {0x00, 0xB5, 0x43},
+    {0x06, 0x5A, 0xB5}, {0x75, 0x46, 0x65}, {0xFF, 0x6E, 0x59}, {0xFF, 0x9D, 0x81},
+};
+
+// Output
+
+static void flush_chunk(pico_gif_t* gif) {
+    if (gif->chunk_len == 0 || gif->error) return;
+    if (fwrite(gif->chunk, 1, gif->chunk_len, gif->file) != gif->chunk_len) {
+        gif->error = true;
+    }
+    gif->file_pos += gif->chunk_len;
+    gif->chunk_len = 0;
+}
+
+static void put_bytes(pico_gif_t* gif, const uint8_t* data, size_t len) {
+    while (len > 0) {
+        size_t n = PICO_GIF_CHUNK_SIZE - gif->chunk_len;
+        if (n > len) n = len;
+        memcpy(gif->chunk + gif->chunk_len, data, n);
+        gif->chunk_len += n;
+        data += n;
+        len -= n;
+        if (gif->chunk_len == PICO_GIF_CHUNK_SIZE) flush_chunk(gif);
+    }
+}
+
+static void put_byte(pico_gif_t* gif, uint8_t b) {
+    put_bytes(gif, &b, 1);
+}
+
+static void put_u16(pico_gif_t* gif, uint16_t v) {
+    uint8_t b[2] = {(uint8_t)(v & 0xFF), (uint8_t)(v >> 8)};
+    put_bytes(gif, b, 2);
+}
+
+// 16 RGB entries for a screen palette (0x5F10 values, bit 7 = extended)
+static void put_color_table(pico_gif_t* gif, const uint8_t* screen_pal) {
+    for (int i = 0; i < 16; i++) {
+        uint8_t c = screen_pal[i];
+        put_bytes(gif, gif_palette[(c & 0x0F) | ((c & 0x80) >> 3)], 3);
+    }
+}
+
+// Rewrites the delay of the last image once its on-screen time is known
+static void patch_delay(pico_gif_t* gif) {
+    if (gif->delay_pos == 0) return;
+    uint16_t cs = gif->delay_cs > 0xFFFF ? 0xFFFF : (uint16_t)gif->delay_cs;
+    uint8_t b[2] = {(uint8_t)(cs & 0xFF), (uint8_t)(cs >> 8)};
+
+    if (gif->delay_pos >= gif->file_pos) {
+        memcpy(gif->chunk + (gif->delay_pos - gif->file_pos), b, 2);
+    } else {
+        // Part of the field may already be on disk; push the rest out first
+        flush_chunk(gif);
+        if (gif->error) return;
+        if (fseek(gif->file, (long)gif->delay_pos, SEEK_SET) != 0 ||
+            fwrite(b, 1, 2, gif->file) != 2 ||
+            fseek(gif->file, 0, SEEK_END) != 0) {
+            gif->error = true;
+        }
+    }
+    gif->delay_pos = 0;
+    gif->delay_cs = 0;
+}
+
+// LZW
+
+static void lzw_reset(pico_gif_t* gif) {
+    memset(gif->hash, 0, PICO_GIF_HASH_SIZE * sizeof(uint16_t));
+    gif->code_size = GIF_MIN_CODE_SIZE + 1;
+    gif->next_code = GIF_FIRST_CODE;
+}
+
+static void lzw_put_code(pico_gif_t* gif, uint16_t code) {
+    gif->bits |= (uint32_t)code << gif->bit_count;
+    gif->bit_count += gif->code_size;
+    while (gif->bit_count >= 8) {
+        gif->block[++gif->block[0]] = (uint8_t)(gif->bits & 0xFF);
+        gif->bits >>= 8;
+        gif->bit_count -= 8;
+        if (gif->block[0] == 255) {
+            put_bytes(gif, gif->block, 256);
+            gif->block[0] = 0;
+        }
+    }
+}
+
+static void lzw_finish(pico_gif_t* gif) {
+    if (gif->bit_count > 0) {
+        gif->block[++gif->block[0]] = (uint8_t)(gif->bits & 0xFF);
+        gif->bits = 0;
+        gif->bit_count = 0;
+    }
+    if (gif->block[0] > 0) {
+        put_bytes(gif, gif->block, gif->block[0] + 1);
+        gif->block[0] = 0;
+    }
+    put_byte(gif, 0);  // Block terminator
+}
+
+static inline uint32_t lzw_slot(uint32_t key) {
+    return (key * 2654435761u) >> (32 - (PICO_GIF_LZW_BITS + 1));
+}
+
+// Returns the code for prefix+pixel, or -1 with *slot set to where it goes.
+// Slots hold codes only; a code's key is looked up to confirm the match,
+// and no code in use is 0.
+static int lzw_find(pico_gif_t* gif, uint16_t prefix, uint8_t pixel, uint32_t* slot) {
+    uint16_t key = (uint16_t)((prefix << 4) | pixel);
+    uint32_t s = lzw_slot(key);
+    while (gif->hash[s] != 0) {
+        uint16_t code = gif->hash[s];
+        if (gif->keys[code] == key) return code;
+        s = (s + 1) & (PICO_GIF_HASH_SIZE - 1);
+    }
+    *slot = s;
+    return -1;
+}
+
+// Called after emitting a code; widening happens before the new entry is
+// added so the decoder, which trails the encoder by one entry, agrees
+static void lzw_add(pico_gif_t* gif, uint16_t prefix, uint8_t pixel, uint32_t slot) {
+    // Clear one entry early: the decoder would otherwise widen past the cap
+    if (gif->next_code == PICO_GIF_DICT_SIZE - 1) {
+        lzw_put_code(gif, GIF_CLEAR_CODE);
+        lzw_reset(gif);
+        return;
+    }
+    if (gif->next_code == (1 << gif->code_size)) {
+        gif->code_size++;
+    }
+    gif->hash[slot] = gif->next_code;
+    gif->keys[gif->next_code] = (uint16_t)((prefix << 4) | pixel);
+    gif->next_code++;
+}
+
+static inline uint8_t screen_pixel(const uint8_t* screen, int x, int y) {
+    uint8_t b = screen[y * 64 + (x >> 1)];
+    return (x & 1) ? (b >> 4) : (b & 0x0F);
+}
+
+static void encode_rect(pico_gif_t* gif, const uint8_t* screen,
+                        int x0, int y0, int w, int h) {
+    // Graphic control extension: disposal "leave in place", delay patched later
+    const uint8_t gce[4] = {0x21, 0xF9, 0x04, 0x04};
+    put_bytes(gif, gce, 4);
+    gif->delay_pos = gif->file_pos + gif->chunk_len;
+    put_u16(gif, 0);
+    put_byte(gif, 0);   // Transparent index (unused)
+    put_byte(gif, 0);
+
+    // Image descriptor, with a 16-entry local color table when the screen
+    // palette differs from the global one
+    bool local = memcmp(gif->pal, gif->global_pal, 16) != 0;
+    put_byte(gif, 0x2C);
+    put_u16(gif, (uint16_t)x0);
+    put_u16(gif, (uint16_t)y0);
+    put_u16(gif, (uint16_t)w);
+    put_u16(gif, (uint16_t)h);
+    put_byte(gif, local ? 0x83 : 0);
+    if (local) put_color_table(gif, gif->pal);
+
+    put_byte(gif, GIF_MIN_CODE_SIZE);
+    lzw_reset(gif);
+    gif->bits = 0;
+    gif->bit_count = 0;
+    gif->block[0] = 0;
+    lzw_put_code(gif, GIF_CLEAR_CODE);
+
+    int prefix = screen_pixel(screen, x0, y0);
+    for (int y = y0; y < y0 + h; y++) {
+        for (int x = (y == y0) ? x0 + 1 : x0; x < x0 + w; x++) {
+            uint8_t pixel = screen_pixel(screen, x, y);
+            uint32_t slot;
+            int code = lzw_find(gif, (uint16_t)prefix, pixel, &slot);
+            if (code >= 0) {
+                prefix = code;
+                continue;
+            }
+            lzw_put_code(gif, (uint16_t)prefix);
+            lzw_add(gif, (uint16_t)prefix, pixel, slot);
+            prefix = pixel;
+        }
+    }
+    lzw_put_code(gif, (uint16_t)prefix);
+    lzw_put_code(gif, GIF_EOI_CODE);
+    lzw_finish(gif);
+}
+
+// Public API
+
+bool pico_gif_start(pico_gif_t* gif, const char* path, uint32_t fps,
+                    const uint8_t* screen_pal) {
+    memset(gif, 0, sizeof(pico_gif_t));
+
+    uint8_t* mem = malloc(PICO_FRAMEBUFFER_SIZE +
+                          PICO_GIF_HASH_SIZE * sizeof(uint16_t) +
+                          PICO_GIF_DICT_SIZE * sizeof(uint16_t) +
+                          PICO_GIF_CHUNK_SIZE);
+    if (!mem) return false;
+
+    gif->file = fopen(path, "wb");
+    if (!gif->file) {
+        free(mem);
+        return false;
+    }
+
+    gif->hash = (uint16_t*)mem;
+    gif->keys = gif->hash + PICO_GIF_HASH_SIZE;
+    gif->prev = (uint8_t*)(gif->keys + PICO_GIF_DICT_SIZE);
+    gif->chunk = gif->prev + PICO_FRAMEBUFFER_SIZE;
+    gif->fps = fps > 0 ? fps : PICO_FPS_DEFAULT;
+    memcpy(gif->global_pal, screen_pal, 16);
+    memcpy(gif->pal, screen_pal, 16);
+
+    // Header and logical screen with a 16-entry global color table
+    put_bytes(gif, (const uint8_t*)"GIF89a", 6);
+    put_u16(gif, PICO_SCREEN_WIDTH);
+    put_u16(gif, PICO_SCREEN_HEIGHT);
+    put_byte(gif, 0xF3);
+    put_byte(gif, 0);
+    put_byte(gif, 0);
+    put_color_table(gif, gif->global_pal);
+
+    // Loop forever
+    const uint8_t netscape[19] = {
+        0x21, 0xFF, 0x0B, 'N', 'E', 'T', 'S', 'C', 'A', 'P', 'E', '2', '.', '0',
+        0x03, 0x01, 0x00, 0x00, 0x00,
+    };
+    put_bytes(gif, netscape, sizeof(netscape));
+    return true;
+}
+
+void pico_gif_frame(pico_gif_t* gif, const uint8_t* screen, const uint8_t* screen_pal) {
+    if (!gif->file || gif->error) return;
+
+    // Find the rows and byte columns that differ from the last image; a
+    // new screen palette recolors every pixel
+    int x0 = 64, x1 = -1, y0 = PICO_SCREEN_HEIGHT, y1 = -1;
+    bool recolor = memcmp(gif->pal, screen_pal, 16) != 0;
+    if (gif->frames == 0 || (recolor && gif->delay_cs >= GIF_MIN_DELAY_CS)) {
+        x0 = 0; x1 = 63; y0 = 0; y1 = PICO_SCREEN_HEIGHT - 1;
+        memcpy(gif->pal, screen_pal, 16);
+    } else if (gif->delay_cs >= GIF_MIN_DELAY_CS) {
+        for (int y = 0; y < PICO_SCREEN_HEIGHT; y++) {
+            const uint8_t* a = screen + y * 64;
+            const uint8_t* b = gif->prev + y * 64;
+            if (memcmp(a, b, 64) == 0) continue;
+            if (y < y0) y0 = y;
+            y1 = y;
+            int l = 0, r = 63;
+            while (a[l] == b[l]) l++;
+            while (a[r] == b[r]) r--;
+            if (l < x0) x0 = l;
+            if (r > x1) x1 = r;
+        }
+    }
+
+    if (y1 >= 0) {
+        patch_delay(gif);
+        encode_rect(gif, screen, x0 * 2, y0, (x1 - x0 + 1) * 2, y1 - y0 + 1);
+        for (int y = y0; y <= y1; y++) {
+            memcpy(gif->prev + y * 64 + x0, screen + y * 64 + x0, x1 - x0 + 1);
+        }
+    }
+
+    // Whatever is on screen now stays there for one more frame
+    uint32_t t = 100 + gif->time_rem;
+    gif->delay_cs += t / gif->fps;
+    gif->time_rem = t % gif->fps;
+    gif->frames++;
+}
+
+bool pico_gif_stop(pico_gif_t* gif) {
+    if (!gif->file) return false;
+
+    if (gif->frames > 0) patch_delay(gif);
+    put_byte(gif, 0x3B);  // Trailer
+    flush_chunk(gif);
+
+    bool ok = !gif->error;
+    if (fclose(gif->file) != 0) ok = false;
+    free(gif->hash);
+    memset(gif, 0, sizeof(pico_gif_t));
+    return ok;
+}
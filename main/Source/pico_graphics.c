@@ -10,105 +10,126 @@
 #define MAX(a, b) ((a) > (b) ? (a) : (b))
 #define CLAMP(x, lo, hi) MIN(MAX(x, lo), hi)
 
-// Apply camera offset
-static inline void apply_camera(pico_ram_t* ram, int* x, int* y) {
-    *x -= ram->ds.camera_x;
-    *y -= ram->ds.camera_y;
+// Rebuild derived draw state from the raw 0x5F00-0x5F3F bytes
+static void rebuild_draw_cache(pico_graphics_t* gfx) {
+    pico_ram_t* ram = gfx->ram;
+    pico_draw_cache_t* dc = &gfx->draw;
+    
+    dc->camera_x = ram->ds.camera_x;
+    dc->camera_y = ram->ds.camera_y;
+    dc->clip_xb = ram->ds.clip_xb;
+    dc->clip_yb = ram->ds.clip_yb;
+    dc->clip_xe = ram->ds.clip_xe;
+    dc->clip_ye = ram->ds.clip_ye;
+    
+    dc->transparent = 0;
+    for (int i = 0; i < 16; i++) {
+        dc->pal[i] = ram->ds.draw_pal[i] & 0x0F;
+        if (ram->ds.draw_pal[i] >> 4) {
+            dc->transparent |= 1 << i;
+        }
+    }
+    
+    dc->fillp = ((uint16_t)ram->ds.fillp[1] << 8) | ram->ds.fillp[0];
+    dc->fillp_trans = ram->ds.fillp_trans & 1;
+    dc->pen[0] = dc->pal[ram->ds.color & 0x0F];
+    dc->pen[1] = dc->pal[(ram->ds.color >> 4) & 0x0F];
+    
+    gfx->draw_dirty = false;
 }
 
-// Check if within clip region (exclusive end bounds like fake-08)
-static inline bool in_clip(pico_ram_t* ram, int x, int y) {
-    return x >= ram->ds.clip_xb && x < ram->ds.clip_xe &&
-           y >= ram->ds.clip_yb && y < ram->ds.clip_ye;
+// Get derived draw state, rebuilding it if the draw state changed.
+// Every public primitive calls this once; static helpers below read
+// gfx->draw directly and assume it is current.
+static inline const pico_draw_cache_t* draw_cache(pico_graphics_t* gfx) {
+    if (gfx->draw_dirty) {
+        rebuild_draw_cache(gfx);
+    }
+    return &gfx->draw;
 }
 
-// Check if color is transparent (bit 4 of draw palette)
-static inline bool is_transparent(pico_ram_t* ram, uint8_t c) {
-    return (ram->ds.draw_pal[c & 0x0F] >> 4) != 0;
+// Apply camera offset
+static inline void apply_camera(const pico_draw_cache_t* dc, int* x, int* y) {
+    *x -= dc->camera_x;
+    *y -= dc->camera_y;
 }
 
-// Get draw-palette mapped color
-static inline uint8_t get_pal_color(pico_ram_t* ram, uint8_t c) {
-    return ram->ds.draw_pal[c & 0x0F] & 0x0F;
+// Check if within clip region (exclusive end bounds like fake-08)
+static inline bool in_clip(const pico_draw_cache_t* dc, int x, int y) {
+    return x >= dc->clip_xb && x < dc->clip_xe &&
+           y >= dc->clip_yb && y < dc->clip_ye;
 }
 
-// Set pixel from sprite (no fill pattern)
-static void set_pixel_sprite(pico_ram_t* ram, int x, int y, uint8_t col) {
-    x &= 127;
-    y &= 127;
-    
-    col = get_pal_color(ram, col);
-    
-    // Apply color bitmask if not 0xFF
+// Apply color bitmask (0x5F5E) if not 0xFF
+static inline uint8_t apply_bitmask(pico_ram_t* ram, int x, int y, uint8_t col) {
     if (ram->hw.color_bitmask != 0xFF) {
         uint8_t write_mask = ram->hw.color_bitmask & 0x0F;
         uint8_t read_mask = ram->hw.color_bitmask >> 4;
         uint8_t src = pico_get_pixel(ram->screen, x, y);
         col = (src & ~write_mask) | (col & write_mask & read_mask);
     }
+    return col;
+}
+
+// Set pixel from sprite (no fill pattern, color already palette-mapped)
+static void set_pixel_sprite(pico_ram_t* ram, int x, int y, uint8_t col) {
+    x &= 127;
+    y &= 127;
     
+    col = apply_bitmask(ram, x, y, col);
     pico_set_pixel(ram->screen, x, y, col);
 }
 
 // Set pixel from pen (with fill pattern support)
-static void set_pixel_pen(pico_ram_t* ram, int x, int y) {
+static void set_pixel_pen(pico_graphics_t* gfx, int x, int y) {
+    const pico_draw_cache_t* dc = &gfx->draw;
+    pico_ram_t* ram = gfx->ram;
     x &= 127;
     y &= 127;
     
-    uint8_t col = ram->ds.color;
-    uint8_t col0 = col & 0x0F;
-    uint8_t col1 = (col >> 4) & 0x0F;
-    uint8_t final_c = col0;
+    uint8_t final_c = dc->pen[0];
     
     // Apply fill pattern
-    uint8_t bit_pos = 15 - ((x & 3) + 4 * (y & 3));
-    uint16_t fillp = ((uint16_t)ram->ds.fillp[1] << 8) | ram->ds.fillp[0];
-    bool alt_color = (fillp >> bit_pos) & 1;
-    
-    if (alt_color) {
-        if (ram->ds.fillp_trans & 1) {
-            return;  // Transparent in fill pattern
+    if (dc->fillp) {
+        uint8_t bit_pos = 15 - ((x & 3) + 4 * (y & 3));
+        if ((dc->fillp >> bit_pos) & 1) {
+            if (dc->fillp_trans) {
+                return;  // Transparent in fill pattern
+            }
+            final_c = dc->pen[1];
         }
-        final_c = col1;
-    }
-    
-    final_c = get_pal_color(ram, final_c);
-    
-    // Apply color bitmask
-    if (ram->hw.color_bitmask != 0xFF) {
-        uint8_t write_mask = ram->hw.color_bitmask & 0x0F;
-        uint8_t read_mask = ram->hw.color_bitmask >> 4;
-        uint8_t src = pico_get_pixel(ram->screen, x, y);
-        final_c = (src & ~write_mask) | (final_c & write_mask & read_mask);
     }
     
+    final_c = apply_bitmask(ram, x, y, final_c);
     pico_set_pixel(ram->screen, x, y, final_c);
 }
 
 // Safe set pixel (checks clip)
-static void safe_set_pixel_pen(pico_ram_t* ram, int x, int y) {
-    if (in_clip(ram, x, y)) {
-        set_pixel_pen(ram, x, y);
+static void safe_set_pixel_pen(pico_graphics_t* gfx, int x, int y) {
+    if (in_clip(&gfx->draw, x, y)) {
+        set_pixel_pen(gfx, x, y);
     }
 }
 
 // Optimized horizontal line
-static void h_line(pico_ram_t* ram, int x1, int x2, int y) {
-    if (y < ram->ds.clip_yb || y >= ram->ds.clip_ye) return;
+static void h_line(pico_graphics_t* gfx, int x1, int x2, int y) {
+    const pico_draw_cache_t* dc = &gfx->draw;
+    pico_ram_t* ram = gfx->ram;
+    
+    if (y < dc->clip_yb || y >= dc->clip_ye) return;
     if (x1 > x2) { int t = x1; x1 = x2; x2 = t; }
     
-    int minx = CLAMP(x1, ram->ds.clip_xb, ram->ds.clip_xe - 1);
-    int maxx = CLAMP(x2, ram->ds.clip_xb, ram->ds.clip_xe - 1);
+    int minx = CLAMP(x1, dc->clip_xb, dc->clip_xe - 1);
+    int maxx = CLAMP(x2, dc->clip_xb, dc->clip_xe - 1);
     
     // Fast path: no fill pattern, no color bitmask
     bool fast = ram->hw.color_bitmask == 0xFF && 
-                ram->ds.fillp[0] == 0 && 
-                ram->ds.fillp[1] == 0 &&
+                dc->fillp == 0 &&
                 maxx - minx > 1;
     
     if (fast) {
         uint8_t* p = ram->screen + y * 64;
-        uint8_t color = get_pal_color(ram, ram->ds.color);
+        uint8_t color = dc->pen[0];
         
         if (minx & 1) {
             p[minx / 2] = (p[minx / 2] & 0x0F) | (color << 4);
@@ -123,25 +144,26 @@ static void h_line(pico_ram_t* ram, int x1, int x2, int y) {
         }
     } else {
         for (int x = minx; x <= maxx; x++) {
-            set_pixel_pen(ram, x, y);
+            set_pixel_pen(gfx, x, y);
         }
     }
 }
 
 // Optimized vertical line
-static void v_line(pico_ram_t* ram, int x, int y1, int y2) {
-    if (x < ram->ds.clip_xb || x >= ram->ds.clip_xe) return;
+static void v_line(pico_graphics_t* gfx, int x, int y1, int y2) {
+    const pico_draw_cache_t* dc = &gfx->draw;
+    pico_ram_t* ram = gfx->ram;
+    
+    if (x < dc->clip_xb || x >= dc->clip_xe) return;
     if (y1 > y2) { int t = y1; y1 = y2; y2 = t; }
     
-    int miny = CLAMP(y1, ram->ds.clip_yb, ram->ds.clip_ye - 1);
-    int maxy = CLAMP(y2, ram->ds.clip_yb, ram->ds.clip_ye - 1);
+    int miny = CLAMP(y1, dc->clip_yb, dc->clip_ye - 1);
+    int maxy = CLAMP(y2, dc->clip_yb, dc->clip_ye - 1);
     
-    bool fast = ram->hw.color_bitmask == 0xFF && 
-                ram->ds.fillp[0] == 0 && 
-                ram->ds.fillp[1] == 0;
+    bool fast = ram->hw.color_bitmask == 0xFF && dc->fillp == 0;
     
     if (fast) {
-        uint8_t color = get_pal_color(ram, ram->ds.color);
+        uint8_t color = dc->pen[0];
         uint8_t mask = (x & 1) ? 0x0F : 0xF0;
         uint8_t nibble = (x & 1) ? (color << 4) : color;
         
@@ -151,11 +173,474 @@ static void v_line(pico_ram_t* ram, int x, int y1, int y2) {
         }
     } else {
         for (int y = miny; y <= maxy; y++) {
-            set_pixel_pen(ram, x, y);
+            set_pixel_pen(gfx, x, y);
         }
     }
 }
 
+// P8SCII Print Engine
+
+#define PRINT_TAB_DEFAULT   16      // Tab stop width when 0x5F5A is 0
+
+// Print attribute bits (0x5F58 layout, also driven by \^ commands)
+#define PRINT_ATTR_ENABLE   0x01
+#define PRINT_ATTR_PADDING  0x02
+#define PRINT_ATTR_WIDE     0x04
+#define PRINT_ATTR_TALL     0x08
+#define PRINT_ATTR_SOLID_BG 0x10
+#define PRINT_ATTR_INVERT   0x20
+#define PRINT_ATTR_STRIPEY  0x40
+#define PRINT_ATTR_CUSTOM   0x80
+
+// Interpreter state for one print call
+typedef struct {
+    int x, y;                   // Cursor (before camera offset)
+    int home_x, home_y;         // Target of \n, \r and \^g
+    int last_x, last_y;         // Last glyph position, for \v
+    int right;                  // Rightmost x reached
+    int wrap_x;                 // \^r wrap boundary, 0 = none
+    int line_h;                 // Tallest line advance on the current line
+    int char_w, char_w_hi;      // \^x override, -1 = from font
+    int char_h;                 // \^y override, -1 = from font
+    int tab_w;
+    uint8_t fg, bg;
+    uint8_t attr;               // PRINT_ATTR_* bits
+} print_state_t;
+
+// One glyph ready to blit
+typedef struct {
+    const uint8_t* bits;        // One byte per row, bit 0 = leftmost pixel
+    uint8_t mask;               // Columns to draw
+    int rows;
+    int advance;
+    int offset_x, offset_y;
+} glyph_t;
+
+// Decode custom font header and per-char metrics from 0x5600
+static void rebuild_font_cache(pico_graphics_t* gfx) {
+    static const int8_t width_adjust[8] = {0, 1, 2, 3, -4, -3, -2, -1};
+    const uint8_t* font = (const uint8_t*)gfx->ram + PICO_ADDR_CUSTOM_FONT;
+    pico_font_cache_t* fc = &gfx->font;
+    
+    fc->width = font[0];
+    fc->width_hi = font[1];
+    fc->height = font[2];
+    fc->offset_x = (int8_t)font[3];
+    fc->offset_y = (int8_t)font[4];
+    bool adjust = font[5] & 0x01;
+    memset(fc->raised, 0, sizeof(fc->raised));
+    
+    for (int c = 0; c < 256; c++) {
+        const uint8_t* glyph = font + c * 8;
+        int adv = c >= 128 ? fc->width_hi : fc->width;
+        int rows = 8;
+        while (rows > 0 && glyph[rows - 1] == 0) rows--;
+        
+        if (c < 16) {
+            rows = 0;  // Header bytes, not glyphs
+        } else if (adjust) {
+            // One nibble per char from 0x5608: width adjust, bit 3 = raise
+            uint8_t nib = font[8 + (c - 16) / 2];
+            nib = ((c - 16) & 1) ? (nib >> 4) : (nib & 0x0F);
+            adv += width_adjust[nib & 7];
+            if (nib & 8) fc->raised[c >> 3] |= 1 << (c & 7);
+        }
+        
+        fc->advance[c] = CLAMP(adv, 0, 255);
+        fc->rows[c] = rows;
+    }
+    
+    gfx->font_dirty = false;
+}
+
+static void get_glyph(pico_graphics_t* gfx, const print_state_t* ps,
+                      uint8_t ch, glyph_t* g) {
+    if (ps->attr & PRINT_ATTR_CUSTOM) {
+        if (gfx->font_dirty) {
+            rebuild_font_cache(gfx);
+        }
+        const pico_font_cache_t* fc = &gfx->font;
+        g->bits = (const uint8_t*)gfx->ram + PICO_ADDR_CUSTOM_FONT + ch * 8;
+        g->mask = 0xFF;
+        g->rows = fc->rows[ch];
+        g->advance = fc->advance[ch];
+        g->offset_x = fc->offset_x;
+        g->offset_y = fc->offset_y - ((fc->raised[ch >> 3] >> (ch & 7)) & 1);
+    } else {
+        const uint8_t* font = gfx->font_data;
+        g->bits = font + ch * 8;
+        g->advance = ch >= 128 ? font[1] : font[0];
+        g->mask = g->advance >= 8 ? 0xFF : (uint8_t)((1 << g->advance) - 1);
+        g->rows = ch >= 16 ? font[2] : 0;
+        g->offset_x = font[3];
+        g->offset_y = font[4];
+    }
+    
+    if (ch >= 128 && ps->char_w_hi >= 0) {
+        g->advance = ps->char_w_hi;
+    } else if (ch < 128 && ps->char_w >= 0) {
+        g->advance = ps->char_w;
+    }
+}
+
+// Line advance for the active font, before tall scaling
+static int font_line_height(pico_graphics_t* gfx, const print_state_t* ps) {
+    if (ps->char_h >= 0) return ps->char_h;
+    if (ps->attr & PRINT_ATTR_CUSTOM) {
+        if (gfx->font_dirty) {
+            rebuild_font_cache(gfx);
+        }
+        return gfx->font.height;
+    }
+    return gfx->font_data[2] + 1;
+}
+
+static inline int print_line_height(pico_graphics_t* gfx, const print_state_t* ps) {
+    int h = font_line_height(gfx, ps);
+    return (ps->attr & PRINT_ATTR_TALL) ? h * 2 : h;
+}
+
+// Plot a palette-mapped pixel in screen space (clipped, no fill pattern)
+static inline void print_pixel(pico_graphics_t* gfx, int x, int y, uint8_t col) {
+    if (in_clip(&gfx->draw, x, y)) {
+        set_pixel_sprite(gfx->ram, x, y, col);
+    }
+}
+
+static void blit_glyph(pico_graphics_t* gfx, const print_state_t* ps,
+                       const glyph_t* g, int x, int y) {
+    const pico_draw_cache_t* dc = &gfx->draw;
+    int zw = (ps->attr & PRINT_ATTR_WIDE) ? 2 : 1;
+    int zh = (ps->attr & PRINT_ATTR_TALL) ? 2 : 1;
+    bool stripey = (ps->attr & PRINT_ATTR_STRIPEY) != 0;
+    uint8_t fg = dc->pal[ps->fg & 0x0F];
+    int cx = x - dc->camera_x;
+    int cy = y - dc->camera_y;
+    
+    // Character cell: background box and invert area
+    if (ps->attr & (PRINT_ATTR_SOLID_BG | PRINT_ATTR_INVERT)) {
+        int pad = (ps->attr & PRINT_ATTR_PADDING) ? 1 : 0;
+        int w = g->advance * zw;
+        int h = print_line_height(gfx, ps);
+        
+        if (ps->attr & PRINT_ATTR_SOLID_BG) {
+            uint8_t bg = dc->pal[ps->bg & 0x0F];
+            for (int py = 0; py < h; py++) {
+                for (int px = 0; px < w; px++) {
+                    print_pixel(gfx, cx - pad + px, cy - pad + py, bg);
+                }
+            }
+        }
+        
+        if (ps->attr & PRINT_ATTR_INVERT) {
+            // Glyph pixels become holes in a pen-colored cell
+            for (int py = 0; py < h; py++) {
+                int gy = py - pad - g->offset_y;
+                gy = gy >= 0 ? gy / zh : -1;
+                uint8_t bits = (gy >= 0 && gy < g->rows) ? (g->bits[gy] & g->mask) : 0;
+                for (int px = 0; px < w; px++) {
+                    int gx = px - pad - g->offset_x;
+                    gx = gx >= 0 ? gx / zw : -1;
+                    if (gx >= 0 && gx < 8 && ((bits >> gx) & 1)) continue;
+                    print_pixel(gfx, cx - pad + px, cy - pad + py, fg);
+                }
+            }
+            return;
+        }
+    }
+    
+    cx += g->offset_x;
+    cy += g->offset_y;
+    
+    if (zw == 1 && zh == 1) {
+        for (int row = 0; row < g->rows; row++) {
+            uint8_t bits = g->bits[row] & g->mask;
+            for (int px = cx; bits; px++, bits >>= 1) {
+                if (bits & 1) print_pixel(gfx, px, cy + row, fg);
+            }
+        }
+        return;
+    }
+    
+    for (int row = 0; row < g->rows; row++) {
+        uint8_t bits = g->bits[row] & g->mask;
+        for (int col = 0; bits; col++, bits >>= 1) {
+            if (!(bits & 1)) continue;
+            for (int dy = 0; dy < zh; dy++) {
+                if (stripey && dy) continue;
+                for (int dx = 0; dx < zw; dx++) {
+                    if (stripey && dx) continue;
+                    print_pixel(gfx, cx + col * zw + dx, cy + row * zh + dy, fg);
+                }
+            }
+        }
+    }
+}
+
+static void print_newline(pico_graphics_t* gfx, print_state_t* ps) {
+    int h = print_line_height(gfx, ps);
+    ps->y += MAX(ps->line_h, h);
+    ps->x = ps->home_x;
+    ps->line_h = 0;
+}
+
+// Draw a glyph at the cursor and advance it
+static void print_put_glyph(pico_graphics_t* gfx, print_state_t* ps, const glyph_t* g) {
+    int adv = (ps->attr & PRINT_ATTR_WIDE) ? g->advance * 2 : g->advance;
+    
+    if (ps->wrap_x > 0 && ps->x + adv > ps->wrap_x && ps->x > ps->home_x) {
+        print_newline(gfx, ps);
+    }
+    
+    blit_glyph(gfx, ps, g, ps->x, ps->y);
+    ps->last_x = ps->x;
+    ps->last_y = ps->y;
+    ps->x += adv;
+    if (ps->x > ps->right) ps->right = ps->x;
+    
+    int h = print_line_height(gfx, ps);
+    if (h > ps->line_h) ps->line_h = h;
+}
+
+// P8SCII parameter character: 0-9, then a-z for 10-35
+static int p8scii_param(uint8_t c) {
+    if (c >= '0' && c <= '9') return c - '0';
+    if (c >= 'a' && c <= 'z') return c - 'a' + 10;
+    if (c >= 'A' && c <= 'Z') return c - 'A' + 10;
+    return 0;
+}
+
+static int hex_nibble(uint8_t c) {
+    if (c >= '0' && c <= '9') return c - '0';
+    if (c >= 'a' && c <= 'f') return c - 'a' + 10;
+    if (c >= 'A' && c <= 'F') return c - 'A' + 10;
+    return 0;
+}
+
+static inline uint8_t next_byte(const char* str, size_t len, size_t* i) {
+    return *i < len ? (uint8_t)str[(*i)++] : 0;
+}
+
+static uint16_t next_hex16(const char* str, size_t len, size_t* i) {
+    uint16_t v = 0;
+    for (int n = 0; n < 4; n++) {
+        v = (v << 4) | hex_nibble(next_byte(str, len, i));
+    }
+    return v;
+}
+
+// Poke from inside a print string (\^@ and \^!). The rest of the
+// string is drawn with whatever draw state the poke left behind.
+static void print_poke(pico_graphics_t* gfx, uint16_t addr, const char* src, size_t n) {
+    for (size_t k = 0; k < n; k++) {
+        pico_poke(gfx->ram, addr + k, (uint8_t)src[k]);
+    }
+    if (gfx->mem_written) {
+        gfx->mem_written(addr, n);
+    } else {
+        pico_graphics_mem_written(gfx, addr, n);
+    }
+    draw_cache(gfx);
+}
+
+// Handle a \^ command. Returns false if printing should stop.
+static bool print_command(pico_graphics_t* gfx, print_state_t* ps,
+                          const char* str, size_t len, size_t* i) {
+    uint8_t cmd = next_byte(str, len, i);
+    bool enable = true;
+    if (cmd == '-') {
+        enable = false;
+        cmd = next_byte(str, len, i);
+    }
+    
+    uint8_t flag = 0;
+    switch (cmd) {
+        case 'c': {
+            pico_cls(gfx, p8scii_param(next_byte(str, len, i)));
+            ps->x = ps->home_x = 0;
+            ps->y = ps->home_y = 0;
+            ps->line_h = 0;
+            break;
+        }
+        case 'd':  // Per-char delay: printing is instant here
+            next_byte(str, len, i);
+            break;
+        case 'g':
+            ps->x = ps->home_x;
+            ps->y = ps->home_y;
+            break;
+        case 'h':
+            ps->home_x = ps->x;
+            ps->home_y = ps->y;
+            break;
+        case 'j':
+            ps->x = p8scii_param(next_byte(str, len, i)) * 4;
+            ps->y = p8scii_param(next_byte(str, len, i)) * 4;
+            break;
+        case 'r':
+            ps->wrap_x = p8scii_param(next_byte(str, len, i)) * 4;
+            break;
+        case 's':
+            ps->tab_w = p8scii_param(next_byte(str, len, i));
+            break;
+        case 'x':
+            ps->char_w = ps->char_w_hi = p8scii_param(next_byte(str, len, i));
+            break;
+        case 'y':
+            ps->char_h = p8scii_param(next_byte(str, len, i));
+            break;
+        case 'w': flag = PRINT_ATTR_WIDE; break;
+        case 't': flag = PRINT_ATTR_TALL; break;
+        case '=': flag = PRINT_ATTR_STRIPEY; break;
+        case 'p': flag = PRINT_ATTR_WIDE | PRINT_ATTR_TALL | PRINT_ATTR_STRIPEY; break;
+        case 'i': flag = PRINT_ATTR_INVERT; break;
+        case 'b': flag = PRINT_ATTR_PADDING; break;
+        case '#': flag = PRINT_ATTR_SOLID_BG; break;
+        case '@': {
+            uint16_t addr = next_hex16(str, len, i);
+            uint16_t n = next_hex16(str, len, i);
+            if (n > len - *i) n = len - *i;
+            print_poke(gfx, addr, str + *i, n);
+            *i += n;
+            break;
+        }
+        case '!': {
+            uint16_t addr = next_hex16(str, len, i);
+            print_poke(gfx, addr, str + *i, len - *i);
+            return false;
+        }
+        case '.':
+        case ':': {
+            // One-off 8x8 glyph: 8 raw bytes or 16 hex digits
+            uint8_t bits[8] = {0};
+            if (cmd == '.') {
+                size_t n = len - *i < sizeof(bits) ? len - *i : sizeof(bits);
+                memcpy(bits, str + *i, n);
+                *i += n;
+            } else {
+                for (size_t row = 0; row < sizeof(bits); row++) {
+                    uint8_t hi = hex_nibble(next_byte(str, len, i));
+                    bits[row] = (hi << 4) | hex_nibble(next_byte(str, len, i));
+                }
+            }
+            glyph_t g;
+            get_glyph(gfx, ps, 128, &g);
+            g.bits = bits;
+            g.mask = 0xFF;
+            g.rows = 8;
+            g.offset_x = 0;
+            g.offset_y = 0;
+            print_put_glyph(gfx, ps, &g);
+            break;
+        }
+        default:
+            // 1-9: frame skips; no mid-print flips here
+            break;
+    }
+    
+    if (flag) {
+        if (enable) ps->attr |= flag;
+        else ps->attr &= ~flag;
+    }
+    return true;
+}
+
+// Run the P8SCII interpreter over str. Returns false if it hit \0.
+static bool print_run(pico_graphics_t* gfx, print_state_t* ps,
+                      const char* str, size_t len) {
+    size_t i = 0;
+    int repeat = 1;
+    
+    while (i < len) {
+        uint8_t c = (uint8_t)str[i++];
+        
+        if (c >= 16) {
+            glyph_t g;
+            get_glyph(gfx, ps, c, &g);
+            for (; repeat > 0; repeat--) {
+                print_put_glyph(gfx, ps, &g);
+            }
+            repeat = 1;
+            continue;
+        }
+        
+        switch (c) {
+            case 0:
+                return false;
+            case 1:  // \* repeat next char
+                repeat = p8scii_param(next_byte(str, len, &i));
+                break;
+            case 2:  // \# background color
+                ps->bg = p8scii_param(next_byte(str, len, &i));
+                ps->attr |= PRINT_ATTR_SOLID_BG;
+                break;
+            case 3:  // \- move cursor x
+                ps->x += p8scii_param(next_byte(str, len, &i)) - 16;
+                break;
+            case 4:  // \| move cursor y
+                ps->y += p8scii_param(next_byte(str, len, &i)) - 16;
+                break;
+            case 5:  // \+ move cursor x, y
+                ps->x += p8scii_param(next_byte(str, len, &i)) - 16;
+                ps->y += p8scii_param(next_byte(str, len, &i)) - 16;
+                break;
+            case 6:  // \^ command
+                if (!print_command(gfx, ps, str, len, &i)) return false;
+                break;
+            case 7:  // \a audio: no synth hook here, skip its parameters
+                while (i < len && (uint8_t)str[i] > ' ') i++;
+                if (i < len && str[i] == ' ') i++;
+                break;
+            case 8: {  // \b backspace
+                glyph_t g;
+                get_glyph(gfx, ps, ' ', &g);
+                ps->x -= (ps->attr & PRINT_ATTR_WIDE) ? g.advance * 2 : g.advance;
+                break;
+            }
+            case 9:  // \t tab
+                if (ps->tab_w > 0) {
+                    ps->x = ps->home_x + ((ps->x - ps->home_x) / ps->tab_w + 1) * ps->tab_w;
+                }
+                break;
+            case 10:  // \n
+                print_newline(gfx, ps);
+                break;
+            case 11: {  // \v decorate previous char
+                int p = p8scii_param(next_byte(str, len, &i));
+                uint8_t ch = next_byte(str, len, &i);
+                glyph_t g;
+                get_glyph(gfx, ps, ch, &g);
+                blit_glyph(gfx, ps, &g, ps->last_x + (p % 4) - 2, ps->last_y + (p / 4) - 8);
+                break;
+            }
+            case 12:  // \f foreground color
+                ps->fg = p8scii_param(next_byte(str, len, &i));
+                break;
+            case 13:  // \r
+                ps->x = ps->home_x;
+                break;
+            case 14:
+                ps->attr |= PRINT_ATTR_CUSTOM;
+                break;
+            case 15:
+                ps->attr &= ~PRINT_ATTR_CUSTOM;
+                break;
+        }
+    }
+    return true;
+}
+
+// Scroll the screen up by n rows, clearing the bottom
+static void scroll_screen(pico_graphics_t* gfx, int n) {
+    uint8_t* screen = gfx->ram->screen;
+    if (n > PICO_SCREEN_HEIGHT) n = PICO_SCREEN_HEIGHT;
+    memmove(screen, screen + n * 64, (PICO_SCREEN_HEIGHT - n) * 64);
+    memset(screen + (PICO_SCREEN_HEIGHT - n) * 64, 0, n * 64);
+    gfx->dirty_top = 0;
+    gfx->dirty_bottom = 127;
+    gfx->needs_flip = true;
+}
+
 // Public API
 
 void pico_graphics_init(pico_graphics_t* gfx, pico_ram_t* ram) {
@@ -169,6 +654,17 @@ void pico_graphics_reset(pico_graphics_t* gfx) {
     gfx->dirty_top = 0;
     gfx->dirty_bottom = 127;
     gfx->needs_flip = true;
+    gfx->draw_dirty = true;
+    gfx->font_dirty = true;
+}
+
+void pico_graphics_mem_written(pico_graphics_t* gfx, uint16_t addr, uint16_t len) {
+    if (pico_range_overlaps(addr, len, PICO_ADDR_DRAW_STATE, PICO_ADDR_HW_STATE)) {
+        gfx->draw_dirty = true;
+    }
+    if (pico_range_overlaps(addr, len, PICO_ADDR_CUSTOM_FONT, PICO_ADDR_PERSIST)) {
+        gfx->font_dirty = true;
+    }
 }
 
 void pico_cls(pico_graphics_t* gfx, uint8_t color) {
@@ -191,15 +687,47 @@ void pico_flip(pico_graphics_t* gfx) {
     gfx->dirty_bottom = 0;
 }
 
+static inline uint32_t hash_mix(uint32_t h, uint32_t k) {
+    k *= 0xCC9E2D51u;
+    k = (k << 15) | (k >> 17);
+    k *= 0x1B873593u;
+    h ^= k;
+    h = (h << 13) | (h >> 19);
+    return h * 5 + 0xE6546B64u;
+}
+
+uint32_t pico_frame_hash(const pico_ram_t* ram, bool with_palette) {
+    // Murmur3-style word mixing: one multiply chain per 8 pixels
+    uint32_t h = 0x9747B28Cu;
+    for (int i = 0; i < PICO_FRAMEBUFFER_SIZE; i += 4) {
+        uint32_t k;
+        memcpy(&k, ram->screen + i, 4);
+        h = hash_mix(h, k);
+    }
+    if (with_palette) {
+        for (int i = 0; i < 16; i += 4) {
+            uint32_t k;
+            memcpy(&k, ram->ds.screen_pal + i, 4);
+            h = hash_mix(h, k);
+        }
+    }
+    h ^= h >> 16;
+    h *= 0x85EBCA6Bu;
+    h ^= h >> 13;
+    h *= 0xC2B2AE35u;
+    h ^= h >> 16;
+    return h;
+}
+
 void pico_pset(pico_graphics_t* gfx, int16_t x, int16_t y, uint8_t col) {
-    pico_ram_t* ram = gfx->ram;
     pico_color(gfx, col);
+    const pico_draw_cache_t* dc = draw_cache(gfx);
     
     int ix = x, iy = y;
-    apply_camera(ram, &ix, &iy);
+    apply_camera(dc, &ix, &iy);
     
-    if (in_clip(ram, ix, iy)) {
-        set_pixel_pen(ram, ix, iy);
+    if (in_clip(dc, ix, iy)) {
+        set_pixel_pen(gfx, ix, iy);
         if (iy < gfx->dirty_top) gfx->dirty_top = iy;
         if (iy > gfx->dirty_bottom) gfx->dirty_bottom = iy;
         gfx->needs_flip = true;
@@ -209,7 +737,7 @@ void pico_pset(pico_graphics_t* gfx, int16_t x, int16_t y, uint8_t col) {
 uint8_t pico_pget(pico_graphics_t* gfx, int16_t x, int16_t y) {
     pico_ram_t* ram = gfx->ram;
     int ix = x, iy = y;
-    apply_camera(ram, &ix, &iy);
+    apply_camera(draw_cache(gfx), &ix, &iy);
     
     if (ix >= 0 && ix < 128 && iy >= 0 && iy < 128) {
         return pico_get_pixel(ram->screen, ix, iy);
@@ -225,19 +753,20 @@ void pico_line(pico_graphics_t* gfx, int16_t x0, int16_t y0,
     ram->ds.line_y = y1;
     ram->ds.line_invalid = 0;
     
-    int ix0 = x0, iy0 = y0, ix1 = x1, iy1 = y1;
-    apply_camera(ram, &ix0, &iy0);
-    apply_camera(ram, &ix1, &iy1);
-    
     pico_color(gfx, col);
+    const pico_draw_cache_t* dc = draw_cache(gfx);
+    
+    int ix0 = x0, iy0 = y0, ix1 = x1, iy1 = y1;
+    apply_camera(dc, &ix0, &iy0);
+    apply_camera(dc, &ix1, &iy1);
     
     // Vertical line optimization
     if (ix0 == ix1) {
-        v_line(ram, ix0, iy0, iy1);
+        v_line(gfx, ix0, iy0, iy1);
     }
     // Horizontal line optimization
     else if (iy0 == iy1) {
-        h_line(ram, ix0, ix1, iy0);
+        h_line(gfx, ix0, ix1, iy0);
     }
     // Bresenham for diagonals
     else {
@@ -246,7 +775,7 @@ void pico_line(pico_graphics_t* gfx, int16_t x0, int16_t y0,
         int err = dx + dy;
         
         for (;;) {
-            safe_set_pixel_pen(ram, ix0, iy0);
+            safe_set_pixel_pen(gfx, ix0, iy0);
             if (ix0 == ix1 && iy0 == iy1) break;
             int e2 = 2 * err;
             if (e2 >= dy) { err += dy; ix0 += sx; }
@@ -270,19 +799,18 @@ void pico_rect(pico_graphics_t* gfx, int16_t x0, int16_t y0,
 
 void pico_rectfill(pico_graphics_t* gfx, int16_t x0, int16_t y0,
                    int16_t x1, int16_t y1, uint8_t col) {
-    pico_ram_t* ram = gfx->ram;
-    
     if (x0 > x1) { int16_t t = x0; x0 = x1; x1 = t; }
     if (y0 > y1) { int16_t t = y0; y0 = y1; y1 = t; }
     
-    int ix0 = x0, iy0 = y0, ix1 = x1, iy1 = y1;
-    apply_camera(ram, &ix0, &iy0);
-    apply_camera(ram, &ix1, &iy1);
-    
     pico_color(gfx, col);
+    const pico_draw_cache_t* dc = draw_cache(gfx);
+    
+    int ix0 = x0, iy0 = y0, ix1 = x1, iy1 = y1;
+    apply_camera(dc, &ix0, &iy0);
+    apply_camera(dc, &ix1, &iy1);
     
     for (int y = iy0; y <= iy1; y++) {
-        h_line(ram, ix0, ix1, y);
+        h_line(gfx, ix0, ix1, y);
     }
     
     gfx->needs_flip = true;
@@ -290,25 +818,24 @@ void pico_rectfill(pico_graphics_t* gfx, int16_t x0, int16_t y0,
 
 void pico_circ(pico_graphics_t* gfx, int16_t ox, int16_t oy,
                int16_t r, uint8_t col) {
-    pico_ram_t* ram = gfx->ram;
     pico_color(gfx, col);
     
     int ix = ox, iy = oy;
-    apply_camera(ram, &ix, &iy);
+    apply_camera(draw_cache(gfx), &ix, &iy);
     
     int x = r;
     int y = 0;
     int dec = 1 - x;
     
     while (y <= x) {
-        safe_set_pixel_pen(ram, ix + x, iy + y);
-        safe_set_pixel_pen(ram, ix + y, iy + x);
-        safe_set_pixel_pen(ram, ix - x, iy + y);
-        safe_set_pixel_pen(ram, ix - y, iy + x);
-        safe_set_pixel_pen(ram, ix - x, iy - y);
-        safe_set_pixel_pen(ram, ix - y, iy - x);
-        safe_set_pixel_pen(ram, ix + x, iy - y);
-        safe_set_pixel_pen(ram, ix + y, iy - x);
+        safe_set_pixel_pen(gfx, ix + x, iy + y);
+        safe_set_pixel_pen(gfx, ix + y, iy + x);
+        safe_set_pixel_pen(gfx, ix - x, iy + y);
+        safe_set_pixel_pen(gfx, ix - y, iy + x);
+        safe_set_pixel_pen(gfx, ix - x, iy - y);
+        safe_set_pixel_pen(gfx, ix - y, iy - x);
+        safe_set_pixel_pen(gfx, ix + x, iy - y);
+        safe_set_pixel_pen(gfx, ix + y, iy - x);
         
         y++;
         if (dec < 0) {
@@ -324,23 +851,22 @@ void pico_circ(pico_graphics_t* gfx, int16_t ox, int16_t oy,
 
 void pico_circfill(pico_graphics_t* gfx, int16_t ox, int16_t oy,
                    int16_t r, uint8_t col) {
-    pico_ram_t* ram = gfx->ram;
     pico_color(gfx, col);
     
     int ix = ox, iy = oy;
-    apply_camera(ram, &ix, &iy);
+    apply_camera(draw_cache(gfx), &ix, &iy);
     
     if (r == 0) {
-        safe_set_pixel_pen(ram, ix, iy);
+        safe_set_pixel_pen(gfx, ix, iy);
     } else if (r == 1) {
-        safe_set_pixel_pen(ram, ix, iy - 1);
-        h_line(ram, ix - 1, ix + 1, iy);
-        safe_set_pixel_pen(ram, ix, iy + 1);
+        safe_set_pixel_pen(gfx, ix, iy - 1);
+        h_line(gfx, ix - 1, ix + 1, iy);
+        safe_set_pixel_pen(gfx, ix, iy + 1);
     } else if (r > 0) {
         int x = -r, y = 0, err = 2 - 2 * r;
         do {
-            h_line(ram, ix - x, ix + x, iy + y);
-            h_line(ram, ix - x, ix + x, iy - y);
+            h_line(gfx, ix - x, ix + x, iy + y);
+            h_line(gfx, ix - x, ix + x, iy - y);
             int sr = err;
             if (sr > x) err += ++x * 2 + 1;
             if (sr <= y) err += ++y * 2 + 1;
@@ -352,8 +878,8 @@ void pico_circfill(pico_graphics_t* gfx, int16_t ox, int16_t oy,
 
 void pico_oval(pico_graphics_t* gfx, int16_t x0, int16_t y0,
                int16_t x1, int16_t y1, uint8_t col) {
-    pico_ram_t* ram = gfx->ram;
     pico_color(gfx, col);
+    const pico_draw_cache_t* dc = draw_cache(gfx);
     
     if (x0 > x1) { int16_t t = x0; x0 = x1; x1 = t; }
     if (y0 > y1) { int16_t t = y0; y0 = y1; y1 = t; }
@@ -363,7 +889,7 @@ void pico_oval(pico_graphics_t* gfx, int16_t x0, int16_t y0,
     long err = dx + dy + b1 * a * a;
     
     int ix0 = x0, iy0 = y0, ix1 = x1;
-    apply_camera(ram, &ix0, &iy0);
+    apply_camera(dc, &ix0, &iy0);
     ix1 = ix0 + a;
     
     iy0 += (b + 1) / 2;
@@ -371,20 +897,20 @@ void pico_oval(pico_graphics_t* gfx, int16_t x0, int16_t y0,
     a *= 8 * a; b1 = 8 * b * b;
     
     do {
-        safe_set_pixel_pen(ram, ix1, iy0);
-        safe_set_pixel_pen(ram, ix0, iy0);
-        safe_set_pixel_pen(ram, ix0, iy1);
-        safe_set_pixel_pen(ram, ix1, iy1);
+        safe_set_pixel_pen(gfx, ix1, iy0);
+        safe_set_pixel_pen(gfx, ix0, iy0);
+        safe_set_pixel_pen(gfx, ix0, iy1);
+        safe_set_pixel_pen(gfx, ix1, iy1);
         long e2 = 2 * err;
         if (e2 >= dx) { ix0++; ix1--; err += dx += b1; }
         if (e2 <= dy) { iy0++; iy1--; err += dy += a; }
     } while (ix0 <= ix1);
     
     while (iy0 - iy1 < b) {
-        safe_set_pixel_pen(ram, ix0 - 1, iy0);
-        safe_set_pixel_pen(ram, ix1 + 1, iy0++);
-        safe_set_pixel_pen(ram, ix0 - 1, iy1);
-        safe_set_pixel_pen(ram, ix1 + 1, iy1--);
+        safe_set_pixel_pen(gfx, ix0 - 1, iy0);
+        safe_set_pixel_pen(gfx, ix1 + 1, iy0++);
+        safe_set_pixel_pen(gfx, ix0 - 1, iy1);
+        safe_set_pixel_pen(gfx, ix1 + 1, iy1--);
     }
     
     gfx->needs_flip = true;
@@ -392,8 +918,8 @@ void pico_oval(pico_graphics_t* gfx, int16_t x0, int16_t y0,
 
 void pico_ovalfill(pico_graphics_t* gfx, int16_t x0, int16_t y0,
                    int16_t x1, int16_t y1, uint8_t col) {
-    pico_ram_t* ram = gfx->ram;
     pico_color(gfx, col);
+    const pico_draw_cache_t* dc = draw_cache(gfx);
     
     if (x0 > x1) { int16_t t = x0; x0 = x1; x1 = t; }
     if (y0 > y1) { int16_t t = y0; y0 = y1; y1 = t; }
@@ -403,7 +929,7 @@ void pico_ovalfill(pico_graphics_t* gfx, int16_t x0, int16_t y0,
     long err = dx + dy + b1 * a * a;
     
     int ix0 = x0, iy0 = y0, ix1 = x1;
-    apply_camera(ram, &ix0, &iy0);
+    apply_camera(dc, &ix0, &iy0);
     ix1 = ix0 + a;
     
     iy0 += (b + 1) / 2;
@@ -411,16 +937,16 @@ void pico_ovalfill(pico_graphics_t* gfx, int16_t x0, int16_t y0,
     a *= 8 * a; b1 = 8 * b * b;
     
     do {
-        h_line(ram, ix0, ix1, iy0);
-        h_line(ram, ix0, ix1, iy1);
+        h_line(gfx, ix0, ix1, iy0);
+        h_line(gfx, ix0, ix1, iy1);
         long e2 = 2 * err;
         if (e2 >= dx) { ix0++; ix1--; err += dx += b1; }
         if (e2 <= dy) { iy0++; iy1--; err += dy += a; }
     } while (ix0 <= ix1);
     
     while (iy0 - iy1 <= b) {
-        h_line(ram, ix0 - 1, ix1 + 1, iy0++);
-        h_line(ram, ix0 - 1, ix1 + 1, iy1--);
+        h_line(gfx, ix0 - 1, ix1 + 1, iy0++);
+        h_line(gfx, ix0 - 1, ix1 + 1, iy1--);
     }
     
     gfx->needs_flip = true;
@@ -443,9 +969,10 @@ void pico_sspr(pico_graphics_t* gfx,
                int16_t dx, int16_t dy, int16_t dw, int16_t dh,
                bool flip_x, bool flip_y) {
     pico_ram_t* ram = gfx->ram;
+    const pico_draw_cache_t* dc = draw_cache(gfx);
     
     int idx = dx, idy = dy;
-    apply_camera(ram, &idx, &idy);
+    apply_camera(dc, &idx, &idy);
     
     // Handle negative dest dimensions
     if (dw < 0) { flip_x = !flip_x; dw = -dw; idx -= dw; }
@@ -463,25 +990,25 @@ void pico_sspr(pico_graphics_t* gfx,
     int ddy = spr_h / dh;
     
     // Clipping
-    if (idx < ram->ds.clip_xb) {
-        int nclip = ram->ds.clip_xb - idx;
-        idx = ram->ds.clip_xb;
+    if (idx < dc->clip_xb) {
+        int nclip = dc->clip_xb - idx;
+        idx = dc->clip_xb;
         dw -= nclip;
         if (!flip_x) spr_x += nclip * ddx;
         else spr_w -= nclip * ddx;
     }
-    if (idx + dw > ram->ds.clip_xe) {
-        dw = ram->ds.clip_xe - idx;
+    if (idx + dw > dc->clip_xe) {
+        dw = dc->clip_xe - idx;
     }
-    if (idy < ram->ds.clip_yb) {
-        int nclip = ram->ds.clip_yb - idy;
-        idy = ram->ds.clip_yb;
+    if (idy < dc->clip_yb) {
+        int nclip = dc->clip_yb - idy;
+        idy = dc->clip_yb;
         dh -= nclip;
         if (!flip_y) spr_y += nclip * ddy;
         else spr_h -= nclip * ddy;
     }
-    if (idy + dh > ram->ds.clip_ye) {
-        dh = ram->ds.clip_ye - idy;
+    if (idy + dh > dc->clip_ye) {
+        dh = dc->clip_ye - idy;
     }
     
     if (dw <= 0 || dh <= 0) return;
@@ -497,8 +1024,8 @@ void pico_sspr(pico_graphics_t* gfx,
             
             uint8_t col = pico_get_pixel(ram->sprites, spx, spy);
             
-            if (!is_transparent(ram, col)) {
-                set_pixel_sprite(ram, idx + px, idy + py, col);
+            if (!((dc->transparent >> col) & 1)) {
+                set_pixel_sprite(ram, idx + px, idy + py, dc->pal[col]);
             }
         }
     }
@@ -554,67 +1081,63 @@ void pico_mset(pico_graphics_t* gfx, int16_t x, int16_t y, uint8_t val) {
     }
 }
 
-void pico_print(pico_graphics_t* gfx, const char* str,
-                int16_t x, int16_t y, uint8_t col) {
+int16_t pico_print(pico_graphics_t* gfx, const char* str, size_t len,
+                   int16_t x, int16_t y, uint8_t col) {
     pico_ram_t* ram = gfx->ram;
-
-    if (x < 0) x = ram->ds.text_x;
-    if (y < 0) y = ram->ds.text_y;
-
-    const uint8_t* font = gfx->font_data;
-    int char_w = font ? font[0] : 4;
-    int char_h = font ? font[2] : 5;
-    int16_t start_x = x;
-
-    while (*str) {
-        char c = *str++;
-        if (c == '\n') {
-            x = start_x;
-            y += char_h + 1;
-            continue;
-        }
-        pico_print_char(gfx, c, x, y, col);
-        x += ((uint8_t)c >= 128 && font) ? font[1] : char_w;
+    pico_color(gfx, col);
+    draw_cache(gfx);
+    
+    print_state_t ps;
+    memset(&ps, 0, sizeof(ps));
+    ps.x = ps.home_x = ps.last_x = ps.right = x;
+    ps.y = ps.home_y = ps.last_y = y;
+    ps.char_w = ps.char_w_hi = ps.char_h = -1;
+    ps.tab_w = ram->hw.print_tab ? ram->hw.print_tab : PRINT_TAB_DEFAULT;
+    ps.fg = col & 0x0F;
+    ps.attr = (ram->hw.print_attr & PRINT_ATTR_ENABLE) ? ram->hw.print_attr
+                                                       : PRINT_ATTR_PADDING;
+    
+    if (print_run(gfx, &ps, str, len)) {
+        print_newline(gfx, &ps);
     }
+    
+    ram->ds.text_x = ps.x;
+    ram->ds.text_y = ps.y;
+    gfx->needs_flip = true;
+    return ps.right;
+}
 
-    ram->ds.text_x = x;
-    ram->ds.text_y = y;
+int16_t pico_print_cursor(pico_graphics_t* gfx, const char* str, size_t len, uint8_t col) {
+    pico_ram_t* ram = gfx->ram;
+    int bottom = PICO_SCREEN_HEIGHT - (gfx->font_data[2] + 1);
+    
+    if (ram->ds.text_y > bottom) {
+        scroll_screen(gfx, ram->ds.text_y - bottom);
+        ram->ds.text_y = bottom;
+    }
+    return pico_print(gfx, str, len, ram->ds.text_x, ram->ds.text_y, col);
 }
 
 void pico_print_char(pico_graphics_t* gfx, char c,
                      int16_t x, int16_t y, uint8_t col) {
-    const uint8_t* font = gfx->font_data;
-    if (!font) return;
-
-    uint8_t ch = (uint8_t)c;
-    if (ch < 16) return;
-
-    int width = font[0];     /* 4 for standard font */
-    int height = font[2];    /* 5 for standard font */
-    int offset_x = font[3];
-    int offset_y = font[4];
-
-    /* Glyph data: 8 bytes per char starting from char 16, at offset 128 */
-    const uint8_t* glyph = &font[128 + (ch - 16) * 8];
-
-    /* For chars >= 128, use the wider width */
-    if (ch >= 128) {
-        width = font[1];  /* 8 for extended chars */
-    }
-
-    for (int row = 0; row < height; row++) {
-        uint8_t bits = glyph[row];
-        for (int px = 0; px < width; px++) {
-            if (bits & (1 << px)) {
-                pico_pset(gfx, x + offset_x + px, y + offset_y + row, col);
-            }
-        }
-    }
+    pico_color(gfx, col);
+    draw_cache(gfx);
+    
+    print_state_t ps;
+    memset(&ps, 0, sizeof(ps));
+    ps.char_w = ps.char_w_hi = ps.char_h = -1;
+    ps.fg = col & 0x0F;
+    
+    glyph_t g;
+    get_glyph(gfx, &ps, (uint8_t)c, &g);
+    blit_glyph(gfx, &ps, &g, x, y);
+    gfx->needs_flip = true;
 }
 
 void pico_camera(pico_graphics_t* gfx, int16_t x, int16_t y) {
     gfx->ram->ds.camera_x = x;
     gfx->ram->ds.camera_y = y;
+    gfx->draw_dirty = true;
 }
 
 void pico_clip(pico_graphics_t* gfx, int16_t x, int16_t y,
@@ -632,16 +1155,23 @@ void pico_clip(pico_graphics_t* gfx, int16_t x, int16_t y,
         ram->ds.clip_xe = CLAMP(x + w, 0, 128);
         ram->ds.clip_ye = CLAMP(y + h, 0, 128);
     }
+    gfx->draw_dirty = true;
 }
 
 void pico_color(pico_graphics_t* gfx, uint8_t col) {
-    gfx->ram->ds.color = col;
+    pico_ram_t* ram = gfx->ram;
+    // Primitives set the pen on every call; only invalidate on change
+    if (ram->ds.color != col) {
+        ram->ds.color = col;
+        gfx->draw_dirty = true;
+    }
 }
 
 void pico_pal(pico_graphics_t* gfx, uint8_t c0, uint8_t c1, uint8_t p) {
     pico_ram_t* ram = gfx->ram;
     if (p == 0) {
         ram->ds.draw_pal[c0 & 0x0F] = c1 & 0x0F;
+        gfx->draw_dirty = true;
     } else {
         ram->ds.screen_pal[c0 & 0x0F] = c1 & 0x8F;
     }
@@ -655,6 +1185,7 @@ void pico_pal_reset(pico_graphics_t* gfx) {
     }
     // PICO-8 default: color 0 is transparent
     ram->ds.draw_pal[0] |= 0x10;
+    gfx->draw_dirty = true;
 }
 
 void pico_palt(pico_graphics_t* gfx, uint8_t col, bool transparent) {
@@ -665,12 +1196,14 @@ void pico_palt(pico_graphics_t* gfx, uint8_t col, bool transparent) {
     } else {
         ram->ds.draw_pal[col] &= 0x0F;
     }
+    gfx->draw_dirty = true;
 }
 
 void pico_fillp(pico_graphics_t* gfx, uint16_t pattern) {
     pico_ram_t* ram = gfx->ram;
     ram->ds.fillp[0] = pattern & 0xFF;
     ram->ds.fillp[1] = (pattern >> 8) & 0xFF;
+    gfx->draw_dirty = true;
 }
 
 uint8_t pico_fget(pico_graphics_t* gfx, int16_t n, uint8_t f) {
@@ -0,0 +1,294 @@
+// pico_heap.c
+// Two-level segregated fit (TLSF) allocator over one fixed arena
+//
+// Free blocks sit in one list per size class; two bitmaps record which
+// lists are non-empty, so finding a fit is two bit scans and freeing
+// merges with both physical neighbours in constant time. Every block
+// carries a two-word header: its size with flags, and the block before
+// it in memory.
+
+#include "pico_heap.h"
+#include <string.h>
+
+#define BLOCK_FREE      ((size_t)1)
+#define BLOCK_PREV_FREE ((size_t)2)
+#define BLOCK_FLAGS     (BLOCK_FREE | BLOCK_PREV_FREE)
+
+struct pico_heap_block {
+    size_t size;                        // Payload bytes | flags
+    pico_heap_block_t* prev_phys;       // Block before this one in memory
+    // Payload; while free it holds the list links
+    pico_heap_block_t* next_free;
+    pico_heap_block_t* prev_free;
+};
+
+#define ALIGN_UP(x)     (((x) + PICO_HEAP_ALIGN - 1) & ~(size_t)(PICO_HEAP_ALIGN - 1))
+#define HEADER_SIZE     ALIGN_UP(offsetof(pico_heap_block_t, next_free))
+#define BLOCK_MIN       ALIGN_UP(sizeof(pico_heap_block_t) - HEADER_SIZE)
+#define BLOCK_MAX       (((size_t)1 << PICO_HEAP_FL_MAX) - PICO_HEAP_ALIGN)
+
+// Blocks
+
+static inline size_t block_size(const pico_heap_block_t* b) {
+    return b->size & ~BLOCK_FLAGS;
+}
+
+static inline void* block_payload(pico_heap_block_t* b) {
+    return (uint8_t*)b + HEADER_SIZE;
+}
+
+static inline pico_heap_block_t* block_from_payload(void* p) {
+    return (pico_heap_block_t*)((uint8_t*)p - HEADER_SIZE);
+}
+
+static inline pico_heap_block_t* block_next(pico_heap_block_t* b) {
+    return (pico_heap_block_t*)((uint8_t*)block_payload(b) + block_size(b));
+}
+
+static inline void block_set_size(pico_heap_block_t* b, size_t size) {
+    b->size = size | (b->size & BLOCK_FLAGS);
+}
+
+// Size Classes
+
+static inline int fls_size(size_t x) {
+    return (int)(sizeof(unsigned long) * 8) - 1 - __builtin_clzl((unsigned long)x);
+}
+
+static void mapping_insert(size_t size, int* fl, int* sl) {
+    if (size < ((size_t)1 << PICO_HEAP_FL_SHIFT)) {
+        *fl = 0;
+        *sl = (int)(size / ((1 << PICO_HEAP_FL_SHIFT) / PICO_HEAP_SL_COUNT));
+    } else {
+        int f = fls_size(size);
+        *sl = (int)(size >> (f - PICO_HEAP_SL_LOG2)) ^ PICO_HEAP_SL_COUNT;
+        *fl = f - PICO_HEAP_FL_SHIFT + 1;
+    }
+}
+
+// Rounds up to the next class boundary so any block in the class fits
+static void mapping_search(size_t size, int* fl, int* sl) {
+    if (size >= ((size_t)1 << PICO_HEAP_FL_SHIFT)) {
+        size += ((size_t)1 << (fls_size(size) - PICO_HEAP_SL_LOG2)) - 1;
+    }
+    mapping_insert(size, fl, sl);
+}
+
+// Free Lists
+
+static void list_remove(pico_heap_t* heap, pico_heap_block_t* b, int fl, int sl) {
+    pico_heap_block_t* prev = b->prev_free;
+    pico_heap_block_t* next = b->next_free;
+    if (next) next->prev_free = prev;
+    if (prev) {
+        prev->next_free = next;
+    } else {
+        heap->free[fl][sl] = next;
+        if (!next) {
+            heap->sl_bitmap[fl] &= ~(1u << sl);
+            if (!heap->sl_bitmap[fl]) heap->fl_bitmap &= ~(1u << fl);
+        }
+    }
+}
+
+static void list_insert(pico_heap_t* heap, pico_heap_block_t* b) {
+    int fl, sl;
+    mapping_insert(block_size(b), &fl, &sl);
+    pico_heap_block_t* head = heap->free[fl][sl];
+    b->prev_free = NULL;
+    b->next_free = head;
+    if (head) head->prev_free = b;
+    heap->free[fl][sl] = b;
+    heap->fl_bitmap |= 1u << fl;
+    heap->sl_bitmap[fl] |= 1u << sl;
+}
+
+static void block_unlink(pico_heap_t* heap, pico_heap_block_t* b) {
+    int fl, sl;
+    mapping_insert(block_size(b), &fl, &sl);
+    list_remove(heap, b, fl, sl);
+}
+
+static pico_heap_block_t* find_free(pico_heap_t* heap, size_t size) {
+    int fl, sl;
+    mapping_search(size, &fl, &sl);
+    if (fl >= PICO_HEAP_FL_COUNT) return NULL;
+
+    uint32_t sl_map = heap->sl_bitmap[fl] & (~0u << sl);
+    if (!sl_map) {
+        uint32_t fl_map = fl + 1 < 32 ? heap->fl_bitmap & (~0u << (fl + 1)) : 0;
+        if (!fl_map) return NULL;
+        fl = __builtin_ctz(fl_map);
+        sl_map = heap->sl_bitmap[fl];
+    }
+    sl = __builtin_ctz(sl_map);
+
+    pico_heap_block_t* b = heap->free[fl][sl];
+    list_remove(heap, b, fl, sl);
+    return b;
+}
+
+// Marks b free, merges it with free neighbours and files it
+static void release(pico_heap_t* heap, pico_heap_block_t* b) {
+    b->size |= BLOCK_FREE;
+
+    if (b->size & BLOCK_PREV_FREE) {
+        pico_heap_block_t* prev = b->prev_phys;
+        block_unlink(heap, prev);
+        block_set_size(prev, block_size(prev) + HEADER_SIZE + block_size(b));
+        b = prev;
+    }
+
+    pico_heap_block_t* next = block_next(b);
+    if (next->size & BLOCK_FREE) {
+        block_unlink(heap, next);
+        block_set_size(b, block_size(b) + HEADER_SIZE + block_size(next));
+        next = block_next(b);
+    }
+
+    next->prev_phys = b;
+    next->size |= BLOCK_PREV_FREE;
+    list_insert(heap, b);
+}
+
+// Cuts a used block down to size, freeing the tail if it can stand alone
+static void trim(pico_heap_t* heap, pico_heap_block_t* b, size_t size) {
+    size_t have = block_size(b);
+    if (have < size + HEADER_SIZE + BLOCK_MIN) return;
+
+    block_set_size(b, size);
+    pico_heap_block_t* rest = block_next(b);
+    rest->size = have - size - HEADER_SIZE;
+    rest->prev_phys = b;
+    block_next(rest)->prev_phys = rest;
+    release(heap, rest);
+}
+
+static inline size_t adjust_size(size_t size) {
+    size = ALIGN_UP(size);
+    return size < BLOCK_MIN ? BLOCK_MIN : size;
+}
+
+// Accounts a used block changing from before to after payload bytes
+static inline void note_used(pico_heap_t* heap, size_t before, size_t after) {
+    heap->used = heap->used - before + after;
+    if (heap->used > heap->peak) heap->peak = heap->used;
+}
+
+// Public API
+
+pico_heap_t* pico_heap_create(void* mem, size_t size) {
+    uintptr_t start = ((uintptr_t)mem + PICO_HEAP_ALIGN - 1) & ~(uintptr_t)(PICO_HEAP_ALIGN - 1);
+    size_t lost = start - (uintptr_t)mem;
+    size_t control = ALIGN_UP(sizeof(pico_heap_t));
+    if (size < lost + control + 2 * HEADER_SIZE + BLOCK_MIN) return NULL;
+
+    pico_heap_t* heap = (pico_heap_t*)start;
+    memset(heap, 0, sizeof(pico_heap_t));
+    heap->size = size;
+
+    // One free block, then a zero-size used sentinel that stops merging
+    size_t span = (size - lost - control) & ~(size_t)(PICO_HEAP_ALIGN - 1);
+    size_t first = span - 2 * HEADER_SIZE;
+    if (first > BLOCK_MAX) first = BLOCK_MAX;
+
+    pico_heap_block_t* b = (pico_heap_block_t*)(start + control);
+    b->size = first;
+    b->prev_phys = NULL;
+    pico_heap_block_t* end = block_next(b);
+    end->size = 0;
+    end->prev_phys = b;
+    release(heap, b);
+    return heap;
+}
+
+void* pico_heap_alloc(pico_heap_t* heap, size_t size) {
+    if (size == 0 || size > BLOCK_MAX) return NULL;
+    size = adjust_size(size);
+
+    pico_heap_block_t* b = find_free(heap, size);
+    if (!b) return NULL;
+
+    b->size &= ~BLOCK_FREE;
+    block_next(b)->size &= ~BLOCK_PREV_FREE;
+    trim(heap, b, size);
+    note_used(heap, 0, HEADER_SIZE + block_size(b));
+    return block_payload(b);
+}
+
+void* pico_heap_alloc_aligned(pico_heap_t* heap, size_t size, size_t align) {
+    if (align <= PICO_HEAP_ALIGN) return pico_heap_alloc(heap, size);
+    if (size == 0 || size > BLOCK_MAX) return NULL;
+    size = adjust_size(size);
+
+    // Enough slack to slide the payload up to the boundary and leave a
+    // free block in front
+    size_t gap_min = HEADER_SIZE + BLOCK_MIN;
+    if (size + align + gap_min > BLOCK_MAX) return NULL;
+    pico_heap_block_t* b = find_free(heap, size + align + gap_min);
+    if (!b) return NULL;
+
+    b->size &= ~BLOCK_FREE;
+    block_next(b)->size &= ~BLOCK_PREV_FREE;
+
+    uintptr_t payload = (uintptr_t)block_payload(b);
+    uintptr_t aligned = (payload + align - 1) & ~(uintptr_t)(align - 1);
+    if (aligned != payload && aligned - payload < gap_min) {
+        aligned = (payload + gap_min + align - 1) & ~(uintptr_t)(align - 1);
+    }
+    size_t gap = aligned - payload;
+    if (gap) {
+        pico_heap_block_t* a = block_from_payload((void*)aligned);
+        a->size = block_size(b) - gap;
+        a->prev_phys = b;
+        block_next(a)->prev_phys = a;
+        block_set_size(b, gap - HEADER_SIZE);
+        release(heap, b);
+        b = a;
+    }
+
+    trim(heap, b, size);
+    note_used(heap, 0, HEADER_SIZE + block_size(b));
+    return block_payload(b);
+}
+
+void pico_heap_free(pico_heap_t* heap, void* ptr) {
+    if (!ptr) return;
+    pico_heap_block_t* b = block_from_payload(ptr);
+    heap->used -= HEADER_SIZE + block_size(b);
+    release(heap, b);
+}
+
+void* pico_heap_realloc(pico_heap_t* heap, void* ptr, size_t size) {
+    if (!ptr) return pico_heap_alloc(heap, size);
+    if (size == 0) {
+        pico_heap_free(heap, ptr);
+        return NULL;
+    }
+    if (size > BLOCK_MAX) return NULL;
+
+    pico_heap_block_t* b = block_from_payload(ptr);
+    size_t have = block_size(b);
+    size = adjust_size(size);
+
+    // Grow into a free successor when it is big enough
+    if (size > have) {
+        pico_heap_block_t* next = block_next(b);
+        size_t joined = have + HEADER_SIZE + block_size(next);
+        if (!(next->size & BLOCK_FREE) || joined < size) {
+            void* p = pico_heap_alloc(heap, size);
+            if (!p) return NULL;
+            memcpy(p, ptr, have);
+            pico_heap_free(heap, ptr);
+            return p;
+        }
+        block_unlink(heap, next);
+        block_set_size(b, joined);
+        block_next(b)->prev_phys = b;
+        block_next(b)->size &= ~BLOCK_PREV_FREE;
+    }
+
+    trim(heap, b, size);
+    note_used(heap, have, block_size(b));
+    return ptr;
+}
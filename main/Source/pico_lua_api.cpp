@@ -13,6 +13,15 @@ extern "C" {
 #include <lauxlib.h>
 #include <cstring>
 #include <cstdio>
+#include <cstdlib>
+#include <climits>
+#include <dirent.h>
+#include <sys/stat.h>
+#include <utime.h>
+
+#ifdef ESP_PLATFORM
+#include "esp_heap_caps.h"
+#endif
 
 #define PICO_DEBUG 1
 #if PICO_DEBUG
@@ -30,10 +39,28 @@ static pico_vm_t* g_vm = nullptr;
 #define AUD (&g_vm->audio)
 #define INP (&g_vm->input)
 
+// CPU Cost
+// The VM charges Lua instructions; builtins charge the PICO-8 system
+// cycles for the pixels or bytes they touch, taken before clipping
+#define CPU_FILL_PIXELS     16      // Pixels per cycle, solid fills
+#define CPU_BLIT_PIXELS     8       // Pixels per cycle, sprite and map blits
+#define CPU_MEM_BYTES       4       // Bytes per cycle, memcpy and memset
+
+static inline void cpu_charge(uint32_t cycles) {
+    g_vm->cpu_sys += cycles;
+}
+
+static inline void cpu_charge_area(int w, int h, int pixels_per_cycle) {
+    uint32_t area = (uint32_t)(abs(w) * abs(h));
+    if (area > PICO_SCREEN_WIDTH * PICO_SCREEN_HEIGHT) area = PICO_SCREEN_WIDTH * PICO_SCREEN_HEIGHT;
+    cpu_charge(area / pixels_per_cycle);
+}
+
 // Graphics API
 static int l_cls(lua_State* L) {
     uint8_t col = luaL_optinteger(L, 1, 0);
     pico_cls(GFX, col);
+    cpu_charge_area(PICO_SCREEN_WIDTH, PICO_SCREEN_HEIGHT, CPU_FILL_PIXELS);
     return 0;
 }
 
@@ -92,6 +119,7 @@ static int l_rectfill(lua_State* L) {
     int16_t y1 = lua_tointeger(L, 4);
     uint8_t c = luaL_optinteger(L, 5, RAM->ds.color);
     pico_rectfill(GFX, x0, y0, x1, y1, c);
+    cpu_charge_area(x1 - x0 + 1, y1 - y0 + 1, CPU_FILL_PIXELS);
     return 0;
 }
 
@@ -110,6 +138,7 @@ static int l_circfill(lua_State* L) {
     int16_t r = luaL_optinteger(L, 3, 4);
     uint8_t c = luaL_optinteger(L, 4, RAM->ds.color);
     pico_circfill(GFX, x, y, r, c);
+    cpu_charge_area(2 * r + 1, 2 * r + 1, CPU_FILL_PIXELS);
     return 0;
 }
 
@@ -130,6 +159,7 @@ static int l_ovalfill(lua_State* L) {
     int16_t y1 = lua_tointeger(L, 4);
     uint8_t c = luaL_optinteger(L, 5, RAM->ds.color);
     pico_ovalfill(GFX, x0, y0, x1, y1, c);
+    cpu_charge_area(x1 - x0 + 1, y1 - y0 + 1, CPU_FILL_PIXELS);
     return 0;
 }
 
@@ -142,6 +172,7 @@ static int l_spr(lua_State* L) {
     bool flip_x = lua_toboolean(L, 6);
     bool flip_y = lua_toboolean(L, 7);
     pico_spr(GFX, n, x, y, w, h, flip_x, flip_y);
+    cpu_charge_area((int)(w * 8), (int)(h * 8), CPU_BLIT_PIXELS);
     return 0;
 }
 
@@ -157,6 +188,7 @@ static int l_sspr(lua_State* L) {
     bool flip_x = lua_toboolean(L, 9);
     bool flip_y = lua_toboolean(L, 10);
     pico_sspr(GFX, sx, sy, sw, sh, dx, dy, dw, dh, flip_x, flip_y);
+    cpu_charge_area(dw, dh, CPU_BLIT_PIXELS);
     return 0;
 }
 
@@ -169,6 +201,7 @@ static int l_map(lua_State* L) {
     int16_t cell_h = luaL_optinteger(L, 6, 64);
     uint8_t layer = luaL_optinteger(L, 7, 0);
     pico_map(GFX, cell_x, cell_y, sx, sy, cell_w, cell_h, layer);
+    cpu_charge_area(cell_w * 8, cell_h * 8, CPU_BLIT_PIXELS);
     return 0;
 }
 
@@ -273,24 +306,25 @@ static int l_fillp(lua_State* L) {
 }
 
 static int l_print(lua_State* L) {
-    const char* str = lua_tostring(L, 1);
+    size_t len;
+    const char* str = lua_tolstring(L, 1, &len);
     if (!str) return 0;
     
-    int16_t x, y;
-    uint8_t c;
+    int16_t right;
     
     if (lua_gettop(L) >= 3) {
-        x = lua_tointeger(L, 2);
-        y = lua_tointeger(L, 3);
-        c = luaL_optinteger(L, 4, RAM->ds.color);
+        int16_t x = lua_tointeger(L, 2);
+        int16_t y = lua_tointeger(L, 3);
+        uint8_t c = luaL_optinteger(L, 4, RAM->ds.color);
+        right = pico_print(GFX, str, len, x, y, c);
     } else {
-        x = RAM->ds.text_x;
-        y = RAM->ds.text_y;
-        c = luaL_optinteger(L, 2, RAM->ds.color);
+        uint8_t c = luaL_optinteger(L, 2, RAM->ds.color);
+        right = pico_print_cursor(GFX, str, len, c);
     }
+    cpu_charge_area((int)len * 4, 6, CPU_BLIT_PIXELS);
     
-    pico_print(GFX, str, x, y, c);
-    return 0;
+    lua_pushinteger(L, right);
+    return 1;
 }
 
 static int l_cursor(lua_State* L) {
@@ -349,8 +383,28 @@ static int l_music(lua_State* L) {
     return 0;
 }
 
+static int l_serial(lua_State* L) {
+    // serial(channel, addr, len) — only 0x808, the PCM audio stream
+    int channel = lua_tointeger(L, 1);
+    uint16_t addr = lua_tointeger(L, 2);
+    uint16_t len = lua_tointeger(L, 3);
+    
+    uint32_t n = 0;
+    if (channel == 0x808 && len <= PICO_RAM_SIZE && addr <= PICO_RAM_SIZE - len) {
+        n = pico_audio_pcm_write(AUD, ((const uint8_t*)RAM) + addr, len);
+    }
+    lua_pushinteger(L, n);
+    return 1;
+}
+
 // Memory API
 
+// Notify subsystems that cache state derived from a written RAM range
+static void ram_written(uint16_t addr, uint16_t len) {
+    pico_graphics_mem_written(GFX, addr, len);
+    pico_audio_mem_written(AUD, addr, len);
+}
+
 static int l_peek(lua_State* L) {
     uint16_t addr = lua_tointeger(L, 1);
     lua_pushinteger(L, pico_peek(RAM, addr));
@@ -361,6 +415,7 @@ static int l_poke(lua_State* L) {
     uint16_t addr = lua_tointeger(L, 1);
     uint8_t val = lua_tointeger(L, 2);
     pico_poke(RAM, addr, val);
+    ram_written(addr, 1);
     return 0;
 }
 
@@ -374,6 +429,7 @@ static int l_poke2(lua_State* L) {
     uint16_t addr = lua_tointeger(L, 1);
     uint16_t val = lua_tointeger(L, 2);
     pico_poke2(RAM, addr, val);
+    ram_written(addr, 2);
     return 0;
 }
 
@@ -387,6 +443,7 @@ static int l_poke4(lua_State* L) {
     uint16_t addr = lua_tointeger(L, 1);
     uint32_t val = lua_tonumber(L, 2);
     pico_poke4(RAM, addr, val);
+    ram_written(addr, 4);
     return 0;
 }
 
@@ -397,6 +454,8 @@ static int l_memcpy(lua_State* L) {
     
     if (len <= PICO_RAM_SIZE && dest <= PICO_RAM_SIZE - len && src <= PICO_RAM_SIZE - len) {
         memmove(((uint8_t*)RAM) + dest, ((uint8_t*)RAM) + src, len);
+        ram_written(dest, len);
+        cpu_charge(len / CPU_MEM_BYTES);
     }
     return 0;
 }
@@ -408,6 +467,8 @@ static int l_memset(lua_State* L) {
     
     if (len <= PICO_RAM_SIZE && dest <= PICO_RAM_SIZE - len) {
         memset(((uint8_t*)RAM) + dest, val, len);
+        ram_written(dest, len);
+        cpu_charge(len / CPU_MEM_BYTES);
     }
     return 0;
 }
@@ -748,19 +809,59 @@ static int l_time(lua_State* L) {
     return 1;
 }
 
+// PICO-8 cycles in one frame at the cart's rate
+static uint32_t cpu_budget(void) {
+    return PICO_CPU_HZ / (g_vm->target_fps ? g_vm->target_fps : PICO_FPS_DEFAULT);
+}
+
 static int l_stat(lua_State* L) {
     int n = lua_tointeger(L, 1);
+    
+    // Audio: 16-26 are the older aliases of 46-56
+    if (n >= 16 && n <= 26) n += 30;
+    if (n >= 46 && n <= 57) {
+        pico_audio_status_t st;
+        pico_audio_get_status(AUD, &st);
+        if (n <= 49) lua_pushinteger(L, st.sfx[n - 46]);
+        else if (n <= 53) lua_pushinteger(L, st.note[n - 50]);
+        else if (n == 54) lua_pushinteger(L, st.pattern);
+        else if (n == 55) lua_pushinteger(L, st.patterns_played);
+        else if (n == 56) lua_pushinteger(L, st.ticks);
+        else lua_pushboolean(L, st.pattern >= 0);
+        return 1;
+    }
+    
     switch (n) {
-        case 0: lua_pushinteger(L, 0); break;  // Memory usage (KB)
-        case 1: lua_pushinteger(L, 100); break;  // CPU usage (%)
+        case 0: lua_pushnumber(L, pico_heap_used(g_vm->lua_heap) / 1024.0); break;  // Memory usage (KB)
+        case 1: lua_pushnumber(L, (double)pico_lua_cpu_used(g_vm) / cpu_budget()); break;  // CPU, 1.0 = whole frame
+        case 2: lua_pushnumber(L, (double)g_vm->cpu_sys / cpu_budget()); break;  // System CPU
         case 7: lua_pushinteger(L, g_vm->target_fps); break;  // FPS
         case 30: lua_pushboolean(L, false); break;  // Keyboard available (no key pressed)
         case 31: lua_pushnil(L); break;  // Keyboard character
+        case 108: lua_pushinteger(L, pico_audio_pcm_queued(AUD)); break;  // PCM samples queued
         default: lua_pushinteger(L, 0); break;
     }
     return 1;
 }
 
+static int l_extcmd(lua_State* L) {
+    // extcmd(cmd) — "rec" starts a GIF capture, "video" finishes it;
+    // "gc_auto", "gc_inc" and "gc_gen" pick the cart's collector
+    const char* cmd = luaL_checkstring(L, 1);
+    if (strcmp(cmd, "rec") == 0) {
+        pico_vm_record_start(g_vm);
+    } else if (strcmp(cmd, "video") == 0) {
+        pico_vm_record_stop(g_vm);
+    } else if (strcmp(cmd, "gc_auto") == 0) {
+        pico_vm_set_gc_mode(g_vm, PICO_GC_AUTO);
+    } else if (strcmp(cmd, "gc_inc") == 0) {
+        pico_vm_set_gc_mode(g_vm, PICO_GC_INCREMENTAL);
+    } else if (strcmp(cmd, "gc_gen") == 0) {
+        pico_vm_set_gc_mode(g_vm, PICO_GC_GENERATIONAL);
+    }
+    return 0;
+}
+
 // Registration
 
 static const luaL_Reg pico_api[] = {
@@ -801,6 +902,7 @@ static const luaL_Reg pico_api[] = {
     // Audio
     {"sfx", l_sfx},
     {"music", l_music},
+    {"serial", l_serial},
     
     // Memory
     {"peek", l_peek},
@@ -837,6 +939,7 @@ static const luaL_Reg pico_api[] = {
     {"time", l_time},
     {"t", l_time},
     {"stat", l_stat},
+    {"extcmd", l_extcmd},
 
     {NULL, NULL}
 };
@@ -853,21 +956,217 @@ static void register_api(lua_State* L) {
     lua_pop(L, 1);
 }
 
+// Lua Heap
+
+// Counts bytes requested for the GC profile; a NULL ptr's osize is the
+// object type, not a size
+static void* lua_heap_alloc(void* ud, void* ptr, size_t osize, size_t nsize) {
+    pico_vm_t* vm = (pico_vm_t*)ud;
+    size_t old = ptr ? osize : 0;
+    if (nsize > old) vm->lua_alloc_bytes += (uint32_t)(nsize - old);
+    return pico_slab_realloc(&vm->lua_slab, ptr, osize, nsize);
+}
+
+static int lua_panic(lua_State* L) {
+    PICO_LOG("lua: panic: %s", lua_tostring(L, -1));
+    return 0;
+}
+
+// Bytecode Cache
+//
+// Parsing a large cart takes longer than loading its dumped chunk, so
+// the first launch writes the compiled chunk next to the carts and later
+// launches load that instead. Any cache failure falls back to the source.
+
+#if PICO_LUA_CACHE
+
+#ifndef NAME_MAX
+#define NAME_MAX 255
+#endif
+
+// Directory, separator, longest file name and terminator
+#define CACHE_PATH_SIZE (sizeof(PICO_LUA_CACHE_DIR) + NAME_MAX + 1)
+
+// FNV-1a over the cache version and the source. lua_load's header check
+// only catches chunk format changes, not a compiler that emits different
+// code, so the version keeps chunks from older builds from matching.
+static uint64_t fnv1a(uint64_t h, const uint8_t* p, size_t len) {
+    for (size_t i = 0; i < len; i++) {
+        h ^= p[i];
+        h *= 0x100000001b3ull;
+    }
+    return h;
+}
+
+static uint64_t cache_key(const char* code, size_t len) {
+    static const uint32_t version = PICO_LUA_CACHE_VERSION;
+    uint64_t h = fnv1a(0xcbf29ce484222325ull, (const uint8_t*)&version, sizeof(version));
+    return fnv1a(h, (const uint8_t*)code, len);
+}
+
+// False when the path doesn't fit out
+static bool cache_path(char* out, size_t size, uint64_t key, const char* ext) {
+    int n = snprintf(out, size, "%s/%016llx.%s", PICO_LUA_CACHE_DIR, (unsigned long long)key, ext);
+    return n > 0 && (size_t)n < size;
+}
+
+static const char* cache_read(lua_State* L, void* ud, size_t* size) {
+    (void)L;
+    static char buf[512];
+    *size = fread(buf, 1, sizeof(buf), (FILE*)ud);
+    return *size ? buf : nullptr;
+}
+
+static int cache_write(lua_State* L, const void* p, size_t size, void* ud) {
+    (void)L;
+    return fwrite(p, 1, size, (FILE*)ud) == size ? 0 : 1;
+}
+
+// Pushes the cached chunk for key; false (nothing pushed) on a miss or
+// a stale entry, which is removed
+static bool cache_load(lua_State* L, uint64_t key) {
+    char path[CACHE_PATH_SIZE];
+    if (!cache_path(path, sizeof(path), key, "luac")) return false;
+    FILE* f = fopen(path, "rb");
+    if (!f) return false;
+
+    int err = lua_load(L, cache_read, f, "cart", "b");
+    fclose(f);
+    if (err != LUA_OK) {
+        PICO_LOG("lua: cache entry rejected: %s", lua_tostring(L, -1));
+        lua_pop(L, 1);
+        remove(path);
+        return false;
+    }
+
+    utime(path, nullptr);     // Recency for eviction
+    return true;
+}
+
+// Drops the least recently used entries, never keep, until the cache
+// fits its cap. FAT mtimes are coarse, so entries written together tie
+// and keep has to be named rather than found.
+static void cache_evict(const char* keep) {
+    DIR* dir = opendir(PICO_LUA_CACHE_DIR);
+    if (!dir) return;
+
+    char path[CACHE_PATH_SIZE];
+    char oldest[CACHE_PATH_SIZE];
+    for (;;) {
+        time_t oldest_time = 0;
+        size_t total = 0;
+        oldest[0] = '\0';
+        rewinddir(dir);
+        struct dirent* e;
+        while ((e = readdir(dir)) != nullptr) {
+            size_t n = strlen(e->d_name);
+            if (n < 5 || strcmp(e->d_name + n - 5, ".luac") != 0) continue;
+            int len = snprintf(path, sizeof(path), "%s/%s", PICO_LUA_CACHE_DIR, e->d_name);
+            if (len <= 0 || (size_t)len >= sizeof(path)) continue;
+            struct stat st;
+            if (stat(path, &st) != 0) continue;
+            total += (size_t)st.st_size;
+            if (strcmp(path, keep) == 0) continue;
+            if (!oldest[0] || st.st_mtime < oldest_time) {
+                oldest_time = st.st_mtime;
+                memcpy(oldest, path, (size_t)len + 1);
+            }
+        }
+        if (total <= PICO_LUA_CACHE_MAX_BYTES || !oldest[0]) break;
+        PICO_LOG("lua: cache evict %s", oldest);
+        if (remove(oldest) != 0) break;
+    }
+    closedir(dir);
+}
+
+// Dumps the chunk on top of the stack; written under a temporary name
+// so an interrupted write never leaves a truncated entry
+static void cache_store(lua_State* L, uint64_t key) {
+    mkdir(PICO_LUA_CACHE_DIR, 0755);
+
+    char tmp[CACHE_PATH_SIZE], path[CACHE_PATH_SIZE];
+    if (!cache_path(tmp, sizeof(tmp), key, "tmp") ||
+        !cache_path(path, sizeof(path), key, "luac")) return;
+    FILE* f = fopen(tmp, "wb");
+    if (!f) return;
+
+    bool ok = lua_dump(L, cache_write, f) == 0;
+    ok = fclose(f) == 0 && ok;
+    if (!ok || rename(tmp, path) != 0) {
+        PICO_LOG("lua: cache write failed");
+        remove(tmp);
+        return;
+    }
+    cache_evict(path);
+}
+
+#endif // PICO_LUA_CACHE
+
+// Pushes the compiled cart, from the cache when it has it
+static int load_chunk(lua_State* L, const char* code, size_t len) {
+#if PICO_LUA_CACHE
+    uint64_t key = cache_key(code, len);
+    if (cache_load(L, key)) {
+        PICO_LOG("lua: loaded from cache");
+        return LUA_OK;
+    }
+    int err = luaL_loadbuffer(L, code, len, "cart");
+    if (err == LUA_OK) cache_store(L, key);
+    return err;
+#else
+    return luaL_loadbuffer(L, code, len, "cart");
+#endif
+}
+
 // Public Interface
 
 extern "C" {
 
+// Reserves the Lua arena, preferring PSRAM; sets *size to what was had
+static void* arena_alloc(size_t* size) {
+    for (size_t n = PICO_LUA_HEAP_SIZE; n >= PICO_LUA_HEAP_MIN; n /= 2) {
+#ifdef ESP_PLATFORM
+        void* p = heap_caps_malloc(n, MALLOC_CAP_SPIRAM | MALLOC_CAP_8BIT);
+        if (!p) p = malloc(n);
+#else
+        void* p = malloc(n);
+#endif
+        if (p) {
+            *size = n;
+            return p;
+        }
+    }
+    return nullptr;
+}
+
 bool pico_lua_init(pico_vm_t* vm) {
     PICO_LOG("lua: init");
     g_vm = vm;
+    vm->graphics.mem_written = ram_written;
     cartdata_enabled = false;
 
-    lua_State* L = luaL_newstate();
+    // The whole Lua heap is reserved up front so the cart can neither
+    // exceed its budget nor fragment the system heap
+    size_t arena_size = 0;
+    vm->lua_arena = arena_alloc(&arena_size);
+    vm->lua_heap = vm->lua_arena ? pico_heap_create(vm->lua_arena, arena_size) : nullptr;
+    if (vm->lua_arena && arena_size < PICO_LUA_HEAP_SIZE) {
+        PICO_LOG("lua: arena cut to %u KB", (unsigned)(arena_size / 1024));
+    }
+    bool heap_ok = vm->lua_heap && pico_slab_init(&vm->lua_slab, vm->lua_heap);
+    lua_State* L = heap_ok ? lua_newstate(lua_heap_alloc, vm) : nullptr;
     if (!L) {
         PICO_LOG("lua: failed to create state");
         snprintf(vm->error_msg, sizeof(vm->error_msg), "Failed to create Lua state");
+        free(vm->lua_arena);
+        vm->lua_arena = nullptr;
+        vm->lua_heap = nullptr;
         return false;
     }
+    lua_atpanic(L, lua_panic);
+#if PICO_GC_IDLE
+    lua_gc(L, LUA_GCSETSTEPMUL, PICO_GC_STEPMUL);
+#endif
     
     // Provide memory to z8lua for @ % $ operators
     lua_setpico8memory(L, (const unsigned char*)&vm->ram);
@@ -887,11 +1186,16 @@ bool pico_lua_init(pico_vm_t* vm) {
 }
 
 void pico_lua_shutdown(pico_vm_t* vm) {
-    PICO_LOG("lua: shutdown");
+    PICO_LOG("lua: shutdown (heap peak %u bytes)",
+             vm->lua_heap ? (unsigned)pico_heap_peak(vm->lua_heap) : 0u);
     if (vm->lua_state) {
         lua_close((lua_State*)vm->lua_state);
         vm->lua_state = nullptr;
     }
+    free(vm->lua_arena);
+    vm->lua_arena = nullptr;
+    vm->lua_heap = nullptr;
+    vm->graphics.mem_written = nullptr;
     g_vm = nullptr;
 }
 
@@ -900,7 +1204,7 @@ bool pico_lua_load(pico_vm_t* vm, const char* code, size_t len) {
     lua_State* L = (lua_State*)vm->lua_state;
     if (!L) return false;
 
-    int err = luaL_loadbuffer(L, code, len, "cart");
+    int err = load_chunk(L, code, len);
     if (err != LUA_OK) {
         snprintf(vm->error_msg, sizeof(vm->error_msg), "Load error: %s", 
                  lua_tostring(L, -1));
@@ -959,6 +1263,55 @@ bool pico_lua_call_draw(pico_vm_t* vm) {
                          vm->error_msg, sizeof(vm->error_msg));
 }
 
+bool pico_lua_gc_step(pico_vm_t* vm) {
+    lua_State* L = (lua_State*)vm->lua_state;
+    if (!L) return false;
+    int done = lua_gc(L, LUA_GCSTEP, 0);
+    return vm->gc_generational || done != 0;
+}
+
+void pico_lua_gc_full(pico_vm_t* vm) {
+    lua_State* L = (lua_State*)vm->lua_state;
+    if (L) lua_gc(L, LUA_GCCOLLECT, 0);
+}
+
+void pico_lua_gc_generational(pico_vm_t* vm, bool on) {
+    lua_State* L = (lua_State*)vm->lua_state;
+    if (L) lua_gc(L, on ? LUA_GCGEN : LUA_GCINC, 0);
+}
+
+void pico_lua_cpu_frame(pico_vm_t* vm) {
+    lua_State* L = (lua_State*)vm->lua_state;
+    if (!L) return;
+    vm->cpu_cycles = pico_lua_cpu_used(vm);
+    vm->cpu_frame_start = lua_getcpucycles(L);
+    vm->cpu_sys = 0;
+}
+
+uint32_t pico_lua_cpu_used(pico_vm_t* vm) {
+    lua_State* L = (lua_State*)vm->lua_state;
+    if (!L) return 0;
+    return lua_getcpucycles(L) - vm->cpu_frame_start + vm->cpu_sys;
+}
+
+uint32_t pico_lua_gc_kb(pico_vm_t* vm) {
+    lua_State* L = (lua_State*)vm->lua_state;
+    return L ? (uint32_t)lua_gc(L, LUA_GCCOUNT, 0) : 0;
+}
+
+uint32_t pico_lua_gc_cycles(pico_vm_t* vm, uint32_t* live_kb) {
+    lua_State* L = (lua_State*)vm->lua_state;
+    size_t live = 0;
+    uint32_t cycles = L ? lua_getgccycles(L, &live) : 0;
+    if (live_kb) *live_kb = (uint32_t)(live / 1024);
+    return cycles;
+}
+
+void pico_lua_seed(pico_vm_t* vm, uint32_t seed) {
+    (void)vm;
+    rng_state = seed ? seed : 1;
+}
+
 const char* pico_lua_get_error(pico_vm_t* vm) {
     return vm->error_msg;
 }
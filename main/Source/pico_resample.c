@@ -0,0 +1,49 @@
+// pico_resample.c
+// Streaming fixed-point sample-rate converter
+//
+// The step is divided out once at init; per output there is one table
+// row (FIR) or one multiply (linear) and no division.
+
+#include "pico_resample.h"
+#include <string.h>
+
+void pico_resampler_init(pico_resampler_t* rs, uint32_t in_rate, uint32_t out_rate, bool fir) {
+    memset(rs, 0, sizeof(pico_resampler_t));
+    rs->step = ((uint64_t)in_rate << 32) / out_rate;
+    rs->fir = fir;
+}
+
+static inline int16_t clamp16(int32_t v) {
+    return v > 32767 ? 32767 : (v < -32768 ? -32768 : (int16_t)v);
+}
+
+void pico_resampler_process(pico_resampler_t* rs, int16_t* in, int16_t* out, uint32_t n) {
+    uint32_t n_in = pico_resampler_input_for(rs, n);
+    int16_t* base = in - PICO_RESAMPLE_TAPS;
+    memcpy(base, rs->hist, sizeof(rs->hist));
+    
+    uint64_t pos = rs->frac;
+    if (rs->fir) {
+        for (uint32_t k = 0; k < n; k++) {
+            const int16_t* w = base + (pos >> 32);
+            const int16_t* c = pico_resample_fir.coef[(uint32_t)pos >> (32 - PICO_RESAMPLE_PHASE_BITS)];
+            int32_t acc = 0;
+            for (int j = 0; j < PICO_RESAMPLE_TAPS; j++) {
+                acc += w[j] * c[j];
+            }
+            out[k] = clamp16(acc >> 15);
+            pos += rs->step;
+        }
+    } else {
+        for (uint32_t k = 0; k < n; k++) {
+            const int16_t* w = base + (pos >> 32) + PICO_RESAMPLE_TAPS / 2 - 1;
+            int32_t f = (int32_t)((uint32_t)pos >> 17);
+            out[k] = (int16_t)(w[0] + (((w[1] - w[0]) * f) >> 15));
+            pos += rs->step;
+        }
+    }
+    
+    // The last TAPS inputs become the next block's history
+    memcpy(rs->hist, base + n_in, sizeof(rs->hist));
+    rs->frac = (uint32_t)pos;
+}
@@ -0,0 +1,212 @@
+// pico_slab.c
+// Size-class slab pools for small objects, carved from a pico_heap
+//
+// Each page serves one size class and threads its free slots through
+// their first word, so allocating and freeing are a pop and a push. A
+// page returns to the heap once empty, except for one spare that stays
+// on its partial list and is re-carved for whichever class next needs a
+// page. The spare goes back too when the heap runs short.
+
+#include "pico_slab.h"
+#include <string.h>
+
+struct pico_slab_page {
+    pico_slab_page_t* next;             // In the class's partial list
+    pico_slab_page_t* prev;
+    void* free;                         // First free slot
+    uint16_t live;                      // Slots handed out
+    uint8_t cls;
+};
+
+#define PAGE_HEADER     ((sizeof(pico_slab_page_t) + PICO_SLAB_STEP - 1) & ~(size_t)(PICO_SLAB_STEP - 1))
+
+static inline size_t class_of(size_t size) {
+    return (size - 1) / PICO_SLAB_STEP;
+}
+
+static inline pico_slab_page_t* page_of(void* p) {
+    return (pico_slab_page_t*)((uintptr_t)p & ~(uintptr_t)(PICO_SLAB_PAGE_SIZE - 1));
+}
+
+static inline size_t page_index(const pico_slab_t* slab, const void* p) {
+    return (size_t)((const uint8_t*)p - slab->base) / PICO_SLAB_PAGE_SIZE;
+}
+
+static inline void page_mark(pico_slab_t* slab, const void* page, bool on) {
+    size_t i = page_index(slab, page);
+    if (on) {
+        slab->pages[i / 32] |= 1u << (i % 32);
+    } else {
+        slab->pages[i / 32] &= ~(1u << (i % 32));
+    }
+}
+
+static inline bool is_slot(const pico_slab_t* slab, const void* p) {
+    if ((const uint8_t*)p < slab->base) return false;
+    size_t i = page_index(slab, p);
+    return i < slab->page_count && (slab->pages[i / 32] & (1u << (i % 32)));
+}
+
+// Partial Lists
+
+static void partial_push(pico_slab_t* slab, pico_slab_page_t* page) {
+    pico_slab_page_t* head = slab->partial[page->cls];
+    page->prev = NULL;
+    page->next = head;
+    if (head) head->prev = page;
+    slab->partial[page->cls] = page;
+}
+
+static void partial_remove(pico_slab_t* slab, pico_slab_page_t* page) {
+    if (page->next) page->next->prev = page->prev;
+    if (page->prev) {
+        page->prev->next = page->next;
+    } else {
+        slab->partial[page->cls] = page->next;
+    }
+}
+
+// Pages
+
+// Gives the spare page back to the heap; false if there was none
+static bool spare_release(pico_slab_t* slab) {
+    pico_slab_page_t* page = slab->spare;
+    if (!page) return false;
+    slab->spare = NULL;
+    partial_remove(slab, page);
+    page_mark(slab, page, false);
+    pico_heap_free(slab->heap, page);
+    return true;
+}
+
+static pico_slab_page_t* page_new(pico_slab_t* slab, size_t cls) {
+    pico_slab_page_t* page = slab->spare;
+    if (page) {
+        slab->spare = NULL;
+        partial_remove(slab, page);
+    } else {
+        page = pico_heap_alloc_aligned(slab->heap, PICO_SLAB_PAGE_SIZE, PICO_SLAB_PAGE_SIZE);
+        if (!page) return NULL;
+        page_mark(slab, page, true);
+    }
+
+    size_t slot = (cls + 1) * PICO_SLAB_STEP;
+    uint8_t* first = (uint8_t*)page + PAGE_HEADER;
+    uint32_t count = (uint32_t)((PICO_SLAB_PAGE_SIZE - PAGE_HEADER) / slot);
+
+    // Thread the slots in address order
+    for (uint32_t i = 0; i + 1 < count; i++) {
+        *(void**)(first + i * slot) = first + (i + 1) * slot;
+    }
+    *(void**)(first + (count - 1) * slot) = NULL;
+
+    page->free = first;
+    page->live = 0;
+    page->cls = (uint8_t)cls;
+    partial_push(slab, page);
+    return page;
+}
+
+static void* slot_alloc(pico_slab_t* slab, size_t size) {
+    size_t cls = class_of(size);
+    pico_slab_page_t* page = slab->partial[cls];
+    if (!page) {
+        page = page_new(slab, cls);
+        if (!page) return NULL;
+    }
+
+    if (page == slab->spare) slab->spare = NULL;
+
+    void* p = page->free;
+    page->free = *(void**)p;
+    page->live++;
+    if (!page->free) partial_remove(slab, page);
+    return p;
+}
+
+static void slot_free(pico_slab_t* slab, void* p) {
+    pico_slab_page_t* page = page_of(p);
+    if (!page->free) partial_push(slab, page);
+    *(void**)p = page->free;
+    page->free = p;
+    page->live--;
+
+    // Keep one empty page so a class hovering at a page boundary
+    // doesn't churn pages
+    if (page->live == 0) {
+        if (!slab->spare) {
+            slab->spare = page;
+            return;
+        }
+        partial_remove(slab, page);
+        page_mark(slab, page, false);
+        pico_heap_free(slab->heap, page);
+    }
+}
+
+// Heap blocks; a failed request is retried once the spare page is freed
+
+static void* heap_alloc(pico_slab_t* slab, size_t size) {
+    void* p = pico_heap_alloc(slab->heap, size);
+    if (!p && spare_release(slab)) p = pico_heap_alloc(slab->heap, size);
+    return p;
+}
+
+static void* heap_realloc(pico_slab_t* slab, void* ptr, size_t size) {
+    void* p = pico_heap_realloc(slab->heap, ptr, size);
+    if (!p && spare_release(slab)) p = pico_heap_realloc(slab->heap, ptr, size);
+    return p;
+}
+
+// Public API
+
+bool pico_slab_init(pico_slab_t* slab, pico_heap_t* heap) {
+    memset(slab, 0, sizeof(pico_slab_t));
+    slab->heap = heap;
+    slab->base = (uint8_t*)((uintptr_t)heap & ~(uintptr_t)(PICO_SLAB_PAGE_SIZE - 1));
+    uint8_t* end = (uint8_t*)heap + heap->size;
+    slab->page_count = (size_t)(end - slab->base + PICO_SLAB_PAGE_SIZE - 1) / PICO_SLAB_PAGE_SIZE;
+
+    size_t bytes = (slab->page_count + 31) / 32 * sizeof(uint32_t);
+    slab->pages = pico_heap_alloc(heap, bytes);
+    if (!slab->pages) return false;
+    memset(slab->pages, 0, bytes);
+    return true;
+}
+
+void* pico_slab_realloc(pico_slab_t* slab, void* ptr, size_t osize, size_t nsize) {
+    if (!ptr) {
+        if (nsize == 0) return NULL;
+        void* p = pico_slab_fits(nsize) ? slot_alloc(slab, nsize) : NULL;
+        return p ? p : heap_alloc(slab, nsize);
+    }
+
+    bool slot = is_slot(slab, ptr);
+    if (nsize == 0) {
+        if (slot) {
+            slot_free(slab, ptr);
+        } else {
+            pico_heap_free(slab->heap, ptr);
+        }
+        return NULL;
+    }
+
+    // A slot's class comes from its page; osize may be smaller
+    size_t room = slot ? (page_of(ptr)->cls + 1) * PICO_SLAB_STEP : 0;
+    if (slot) {
+        if (nsize <= room && nsize > room - PICO_SLAB_STEP) return ptr;
+    } else if (!pico_slab_fits(nsize)) {
+        return heap_realloc(slab, ptr, nsize);
+    }
+
+    // Moving between a slot and a heap block, or between classes. A
+    // shrink must not fail, so it stays put when nothing smaller is free.
+    void* p = pico_slab_realloc(slab, NULL, 0, nsize);
+    if (!p) {
+        if (slot) return nsize <= room ? ptr : NULL;
+        return heap_realloc(slab, ptr, nsize);
+    }
+    memcpy(p, ptr, osize < nsize ? osize : nsize);
+    pico_slab_realloc(slab, ptr, osize, 0);
+    return p;
+}
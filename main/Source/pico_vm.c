@@ -5,6 +5,8 @@
 #include "pico_lua_api.h"
 #include <string.h>
 #include <stdio.h>
+#include <time.h>
+#include <sys/stat.h>
 
 #define LUA_CODE_BUFFER_SIZE (32 * 1024)  // 32KB max Lua code
 
@@ -16,6 +18,66 @@
 #define PICO_LOG(fmt, ...) ((void)0)
 #endif
 
+uint32_t pico_vm_time_us(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint32_t)ts.tv_sec * 1000000u + (uint32_t)(ts.tv_nsec / 1000);
+}
+
+// GC Mode
+
+static void gc_set_generational(pico_vm_t* vm, bool on) {
+    if (vm->gc_generational == on) return;
+    pico_lua_gc_generational(vm, on);
+    vm->gc_generational = on;
+    vm->gc_idle_kb = 0;
+}
+
+// Opens a profile window. Live sizes come from what the heap held as
+// collection cycles finished, so nothing is forced mid-game; the only
+// full collection is the one at load.
+static void gc_profile_start(pico_vm_t* vm) {
+    uint32_t fps = vm->target_fps ? vm->target_fps : PICO_FPS_DEFAULT;
+    vm->gc_profile_frame = vm->frame_count + PICO_GC_PROFILE_SECONDS * fps;
+    vm->gc_profile_alloc = vm->lua_alloc_bytes;
+    vm->gc_profile_cycles = pico_lua_gc_cycles(vm, &vm->gc_profile_kb);
+    vm->gc_profile_us = 0;
+}
+
+// Closes a profile window. After the incremental window, carts that
+// allocate much more than they keep go generational, and a second
+// window measures what that did to the idle GC time. A window no cycle
+// finished in allocated too little to be worth switching.
+static void gc_profile_end(pico_vm_t* vm) {
+    uint32_t frames = PICO_GC_PROFILE_SECONDS * (vm->target_fps ? vm->target_fps : PICO_FPS_DEFAULT);
+    uint32_t gc_us = vm->gc_profile_us / frames;
+    vm->gc_profile_frame = 0;
+
+    if (vm->gc_generational) {
+        PICO_LOG("gc: generational, idle gc %u us/frame (incremental %u)",
+                 (unsigned)gc_us, (unsigned)vm->gc_inc_us);
+        return;
+    }
+
+    uint32_t live;
+    uint32_t cycles = pico_lua_gc_cycles(vm, &live) - vm->gc_profile_cycles;
+    uint32_t alloc = vm->lua_alloc_bytes - vm->gc_profile_alloc;
+    uint32_t grown = live > vm->gc_profile_kb ? live - vm->gc_profile_kb : 0;
+    uint32_t alloc_kb = alloc / 1024;
+    uint32_t churn = alloc_kb / PICO_GC_PROFILE_SECONDS * 100 / (live ? live : 1);
+    uint32_t survival = alloc_kb ? grown * 100 / alloc_kb : 100;
+    bool gen = cycles > 0 && churn >= PICO_GC_GEN_CHURN && survival <= PICO_GC_GEN_SURVIVAL;
+    PICO_LOG("gc: %u KB/s allocated, %u cycles, %u KB live, %u%% survived, idle gc %u us/frame -> %s",
+             (unsigned)(alloc_kb / PICO_GC_PROFILE_SECONDS), (unsigned)cycles, (unsigned)live,
+             (unsigned)survival, (unsigned)gc_us, gen ? "generational" : "incremental");
+
+    vm->gc_inc_us = gc_us;
+    if (gen) {
+        gc_set_generational(vm, true);
+        gc_profile_start(vm);
+    }
+}
+
 bool pico_vm_init(pico_vm_t* vm) {
     memset(vm, 0, sizeof(pico_vm_t));
     
@@ -45,6 +107,7 @@ bool pico_vm_init(pico_vm_t* vm) {
 
 void pico_vm_shutdown(pico_vm_t* vm) {
     pico_vm_stop(vm);
+    pico_vm_record_stop(vm);
     
     pico_lua_shutdown(vm);
     
@@ -62,6 +125,17 @@ void pico_vm_reset(pico_vm_t* vm) {
     pico_audio_reset(&vm->audio);
     
     vm->frame_count = 0;
+    vm->frame_hash = 0;
+    vm->prev_frame_hash = 0;
+    vm->frame_us = 0;
+    vm->gc_us = 0;
+    vm->gc_idle_kb = 0;
+    vm->gc_mode = PICO_GC_AUTO;
+    vm->gc_profile_frame = 0;
+    if (vm->gc_generational) {
+        pico_lua_gc_generational(vm, false);
+        vm->gc_generational = false;
+    }
     vm->has_init = false;
     vm->has_update = false;
     vm->has_update60 = false;
@@ -134,6 +208,7 @@ bool pico_vm_load_cart_mem(pico_vm_t* vm, const uint8_t* data, size_t len) {
 
 void pico_vm_unload_cart(pico_vm_t* vm) {
     pico_vm_stop(vm);
+    pico_vm_record_stop(vm);
     pico_vm_reset(vm);
     
     memset(&vm->cart_info, 0, sizeof(vm->cart_info));
@@ -152,6 +227,14 @@ void pico_vm_run(pico_vm_t* vm) {
             vm->state = PICO_VM_ERROR;
         }
     }
+    
+    // _init may have picked a collector with extcmd
+#if PICO_GC_AUTO_GEN
+    if (vm->gc_mode == PICO_GC_AUTO) {
+        pico_lua_gc_full(vm);
+        gc_profile_start(vm);
+    }
+#endif
 }
 
 void pico_vm_stop(pico_vm_t* vm) {
@@ -170,8 +253,40 @@ void pico_vm_resume(pico_vm_t* vm) {
     }
 }
 
+// Steps the collector for part of the time left before the deadline.
+// Once a cycle ends, idle stepping waits for the heap to grow again
+// rather than starting cycles back to back.
+void pico_vm_gc_idle(pico_vm_t* vm, uint32_t deadline_us) {
+#if PICO_GC_IDLE
+    if (vm->state != PICO_VM_RUNNING) return;
+    uint32_t now = pico_vm_time_us();
+    int32_t left = (int32_t)(deadline_us - now);
+    if (left <= 0) return;
+    if (pico_lua_gc_kb(vm) < vm->gc_idle_kb) return;
+
+    uint32_t budget = (uint32_t)left * PICO_GC_IDLE_PERCENT / 100;
+    uint32_t t = now;
+    while (t - now < budget) {
+        if (pico_lua_gc_step(vm)) {
+            vm->gc_idle_kb = pico_lua_gc_kb(vm) * PICO_GC_IDLE_PAUSE / 100;
+            t = pico_vm_time_us();
+            break;
+        }
+        t = pico_vm_time_us();
+    }
+    vm->gc_us = t - now;
+    vm->gc_profile_us += vm->gc_us;
+#else
+    (void)vm;
+    (void)deadline_us;
+#endif
+}
+
 void pico_vm_step(pico_vm_t* vm) {
     if (vm->state != PICO_VM_RUNNING) return;
+    uint32_t start = pico_vm_time_us();
+    vm->gc_us = 0;
+    pico_lua_cpu_frame(vm);
     
     // Call _update() or _update60()
     if (vm->has_update60) {
@@ -199,10 +314,25 @@ void pico_vm_step(pico_vm_t* vm) {
         }
     }
     
-    pico_audio_update(&vm->audio);
+    vm->prev_frame_hash = vm->frame_hash;
+    vm->frame_hash = pico_frame_hash(&vm->ram, PICO_FRAME_HASH_PALETTE);
+    if (pico_gif_active(&vm->gif)) {
+        pico_gif_frame(&vm->gif, vm->ram.screen, vm->ram.ds.screen_pal);
+    }
     pico_flip(&vm->graphics);
     
     vm->frame_count++;
+    vm->frame_us = pico_vm_time_us() - start;
+    if (vm->gc_profile_frame && vm->frame_count >= vm->gc_profile_frame) {
+        gc_profile_end(vm);
+    }
+#if PICO_DEBUG_TIMING
+    if (vm->frame_count % vm->target_fps == 0) {
+        PICO_LOG("frame %u us, gc %u us, heap %u KB, cpu %u%%", (unsigned)vm->frame_us,
+                 (unsigned)vm->gc_us, (unsigned)pico_lua_gc_kb(vm),
+                 (unsigned)(pico_lua_cpu_used(vm) * 100ull * vm->target_fps / PICO_CPU_HZ));
+    }
+#endif
 }
 
 void pico_vm_main_loop(pico_vm_t* vm) {
@@ -211,6 +341,49 @@ void pico_vm_main_loop(pico_vm_t* vm) {
     }
 }
 
+void pico_vm_set_gc_mode(pico_vm_t* vm, pico_gc_mode_t mode) {
+    vm->gc_mode = mode;
+    vm->gc_profile_frame = 0;
+    gc_set_generational(vm, mode == PICO_GC_GENERATIONAL);
+#if PICO_GC_AUTO_GEN
+    if (mode == PICO_GC_AUTO && vm->state == PICO_VM_RUNNING) gc_profile_start(vm);
+#endif
+}
+
+bool pico_vm_record_start(pico_vm_t* vm) {
+    pico_vm_record_stop(vm);
+    
+    // Pick the first unused rec_N.gif so earlier captures are kept
+    mkdir(PICO_CAPTURE_DIR, 0755);
+    char path[128];
+    bool found = false;
+    for (int i = 0; i < 1000 && !found; i++) {
+        snprintf(path, sizeof(path), PICO_CAPTURE_DIR "/rec_%d.gif", i);
+        FILE* f = fopen(path, "rb");
+        found = f == NULL;
+        if (f) fclose(f);
+    }
+    if (!found) {
+        PICO_LOG("rec: no free rec_N.gif in " PICO_CAPTURE_DIR);
+        return false;
+    }
+    
+    if (!pico_gif_start(&vm->gif, path, vm->target_fps, vm->ram.ds.screen_pal)) {
+        PICO_LOG("rec: cannot open %s", path);
+        return false;
+    }
+    PICO_LOG("rec: recording to %s", path);
+    return true;
+}
+
+bool pico_vm_record_stop(pico_vm_t* vm) {
+    if (!pico_gif_active(&vm->gif)) return false;
+    uint32_t frames = vm->gif.frames;
+    bool ok = pico_gif_stop(&vm->gif);
+    PICO_LOG("rec: stopped after %u frames%s", (unsigned)frames, ok ? "" : " (write error)");
+    return ok;
+}
+
 const char* pico_vm_get_error(pico_vm_t* vm) {
     return vm->error_msg;
 }
@@ -222,3 +395,7 @@ uint32_t pico_vm_get_fps(pico_vm_t* vm) {
 uint32_t pico_vm_get_frame_count(pico_vm_t* vm) {
     return vm->frame_count;
 }
+
+uint32_t pico_vm_get_gc_us(pico_vm_t* vm) {
+    return vm->gc_us;
+}
@@ -0,0 +1,133 @@
+// pico_wavetable.cpp
+// Oscillator, pitch, resampler and distortion tables, built by constexpr
+// so they land in flash
+
+#include "pico_wavetable.h"
+#include "pico_audio.h"
+
+namespace {
+
+// Waveform shapes over a 16-bit phase position, as the old per-sample
+// switch computed them
+constexpr int32_t triangle(int32_t pos) {
+    return pos < 0x8000 ? pos * 2 - 0x8000 : 0x8000 - (pos - 0x8000) * 2;
+}
+
+constexpr int32_t wave_value(int wave, int32_t pos) {
+    switch (wave) {
+        case PICO_WAVE_TRIANGLE:
+            return triangle(pos);
+        case PICO_WAVE_TILTED:
+            return pos < 0xE000 ? (int32_t)((int64_t)pos * 0x10000 / 0xE000) - 0x8000
+                                : 0x8000 - (pos - 0xE000) * 0x10000 / 0x2000;
+        case PICO_WAVE_SAWTOOTH:
+            return pos - 0x8000;
+        case PICO_WAVE_SQUARE:
+            return pos < 0x8000 ? -0x7FFF : 0x7FFF;
+        case PICO_WAVE_PULSE:
+            return pos < 0x4000 ? -0x7FFF : 0x7FFF;
+        case PICO_WAVE_ORGAN:
+            return (triangle(pos) + triangle((pos * 2) & 0xFFFF) / 2) * 2 / 3;
+        case PICO_WAVE_PHASER:
+            return ((pos - 0x8000) + (((pos + 0x4000) & 0xFFFF) - 0x8000)) / 2;
+        default:
+            return 0;
+    }
+}
+
+constexpr pico_wavetables_t make_wavetables() {
+    pico_wavetables_t t{};
+    for (int w = 0; w < 8; w++) {
+        for (int i = 0; i < PICO_WAVETABLE_SIZE; i++) {
+            int32_t pos = i << (16 - PICO_WAVETABLE_BITS);
+            t.wave[w][i] = (int16_t)(wave_value(w, pos) >> 1);
+        }
+    }
+    return t;
+}
+
+// Equal temperament from A-2 (note 33) = 440Hz
+constexpr double note_hz(int note) {
+    constexpr double semitone = 1.0594630943592952646;
+    double hz = 440.0;
+    for (int n = 33; n < note; n++) hz *= semitone;
+    for (int n = 33; n > note; n--) hz /= semitone;
+    return hz;
+}
+
+constexpr pico_note_tables_t make_note_tables() {
+    pico_note_tables_t t{};
+    for (int n = 0; n < PICO_NOTE_COUNT; n++) {
+        double hz = note_hz(n);
+        t.phase_inc[n] = (uint32_t)(hz * 4294967296.0 / PICO_SAMPLE_RATE + 0.5);
+        t.freq[n] = (fix32_t)(hz * FIX32_ONE + 0.5);
+    }
+    return t;
+}
+
+// Taylor series after reduction to [-pi, pi]; plenty for 16-bit taps
+constexpr double PI = 3.14159265358979323846;
+
+constexpr double sine(double x) {
+    while (x > PI) x -= 2 * PI;
+    while (x < -PI) x += 2 * PI;
+    double term = x, sum = x;
+    for (int n = 1; n < 12; n++) {
+        term *= -x * x / ((2 * n) * (2 * n + 1));
+        sum += term;
+    }
+    return sum;
+}
+
+constexpr double sinc(double x) {
+    return x > -1e-9 && x < 1e-9 ? 1.0 : sine(PI * x) / (PI * x);
+}
+
+// Cutoff just under the lower of the two Nyquist rates
+constexpr double fir_cutoff() {
+    return PICO_AUDIO_DEVICE_RATE < PICO_SAMPLE_RATE
+        ? 0.9 * PICO_AUDIO_DEVICE_RATE / PICO_SAMPLE_RATE : 0.9;
+}
+
+constexpr pico_resample_fir_t make_resample_fir() {
+    pico_resample_fir_t t{};
+    constexpr double half = PICO_RESAMPLE_TAPS / 2;
+    for (int p = 0; p < PICO_RESAMPLE_PHASES; p++) {
+        double f = (double)p / PICO_RESAMPLE_PHASES;
+        double h[PICO_RESAMPLE_TAPS] = {};
+        double sum = 0;
+        for (int j = 0; j < PICO_RESAMPLE_TAPS; j++) {
+            double d = j - (half - 1) - f;
+            double window = 0.5 + 0.5 * sine(PI * d / half + PI / 2);
+            h[j] = fir_cutoff() * sinc(fir_cutoff() * d) * window;
+            sum += h[j];
+        }
+        // Unity gain at DC for every phase
+        for (int j = 0; j < PICO_RESAMPLE_TAPS; j++) {
+            double c = h[j] / sum * 32768.0;
+            t.coef[p][j] = (int16_t)(c < 0 ? c - 0.5 : c + 0.5);
+        }
+    }
+    return t;
+}
+
+// Cubic soft clip with 2.5x drive: loud notes flatten and buzz, quiet
+// ones are boosted, peak level is unchanged
+constexpr pico_distort_table_t make_distort_table() {
+    pico_distort_table_t t{};
+    for (int i = 0; i < PICO_DISTORT_SIZE; i++) {
+        double x = (i - 128) / 128.0 * 2.5;
+        if (x > 1) x = 1;
+        if (x < -1) x = -1;
+        double y = 1.5 * x - 0.5 * x * x * x;
+        t.curve[i] = (int16_t)(y * 14336);
+    }
+    return t;
+}
+
+} // namespace
+
+extern "C" constexpr pico_wavetables_t pico_wavetables = make_wavetables();
+extern "C" constexpr pico_note_tables_t pico_note_tables = make_note_tables();
+extern "C" constexpr pico_resample_fir_t pico_resample_fir = make_resample_fir();
+extern "C" constexpr pico_distort_table_t pico_distort_table = make_distort_table();
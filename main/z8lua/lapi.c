@@ -141,6 +141,17 @@ LUA_API void lua_setpico8memory (lua_State *L, unsigned char const *p) {
 }
 
 
+LUA_API unsigned lua_getcpucycles (lua_State *L) {
+  return G(L)->cpucycles;
+}
+
+
+LUA_API unsigned lua_getgccycles (lua_State *L, size_t *live) {
+  if (live) *live = G(L)->gclive;
+  return G(L)->gccycles;
+}
+
+
 LUA_API const lua_Number *lua_version (lua_State *L) {
   static const lua_Number version = LUA_VERSION_NUM;
   if (L == NULL) return &version;
@@ -1095,6 +1095,8 @@ static lu_mem singlestep (lua_State *L) {
         sweeplist(L, &mt, 1);
         checkSizes(L);
         g->gcstate = GCSpause;  /* finish collection */
+        g->gccycles++;
+        g->gclive = gettotalbytes(g);
         return GCSWEEPCOST;
       }
     }
@@ -296,7 +296,8 @@ static int pico8_ord(lua_State *l) {
     if (size_t(n + count) > len)
         count = len - n;
     // min stack is only 20. This could be a much longer string
-    lua_checkstack(l, count);
+    if (!lua_checkstack(l, count))
+        return luaL_error(l, "not enough memory");
     for (int i = 0; i < count; ++i)
         lua_pushnumber(l, uint8_t(s[n + i]));
     return count;
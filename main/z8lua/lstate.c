@@ -291,6 +291,10 @@ LUA_API lua_State *lua_newstate (lua_Alloc f, void *ud) {
   setnilvalue(&g->l_registry);
   luaZ_initbuffer(L, &g->buff);
   g->panic = NULL;
+  g->pico8memory = NULL;
+  g->cpucycles = 0;
+  g->gccycles = 0;
+  g->gclive = 0;
   g->version = NULL;
   g->gcstate = GCSpause;
   g->allgc = NULL;
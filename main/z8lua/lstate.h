@@ -141,6 +141,9 @@ typedef struct global_State {
   int gcstepmul;  /* GC `granularity' */
   lua_CFunction panic;  /* to be called in unprotected errors */
   lu_byte const *pico8memory;  /* pointer to PICO-8 RAM */
+  lu_int32 cpucycles;  /* PICO-8 CPU cost of the instructions run, wraps */
+  lu_int32 gccycles;  /* collection cycles finished, wraps */
+  lu_mem gclive;  /* bytes in use when the last cycle finished */
   struct lua_State *mainthread;
   const lua_Number *version;  /* pointer to version number */
   TString *memerrmsg;  /* memory-error message */
@@ -258,6 +258,8 @@ LUA_API int   (lua_setmetatable) (lua_State *L, int objindex);
 LUA_API void  (lua_setuservalue) (lua_State *L, int idx);
 
 LUA_API void  (lua_setpico8memory) (lua_State *L, unsigned char const *p);
+LUA_API unsigned (lua_getcpucycles) (lua_State *L);
+LUA_API unsigned (lua_getgccycles) (lua_State *L, size_t *live);
 
 /*
 ** 'load' and 'call' functions (load and run Lua code)
@@ -571,6 +571,72 @@ void luaV_finishOp (lua_State *L) {
         } \
         else { Protect(luaV_arith(L, ra, rb, rb, tm)); } }
 
+/*
+** PICO-8 CPU cycles charged per instruction, approximating its cost
+** model: register moves, arithmetic and branches cost one cycle, table
+** access two, and calls, allocation and concatenation more. One entry
+** per opcode in lopcodes.h order; the size is checked below, so a new
+** opcode cannot silently shift the costs or index past the end
+*/
+static const lu_byte opcost[] = {
+  1,  /* OP_MOVE */
+  1,  /* OP_LOADK */
+  1,  /* OP_LOADKX */
+  1,  /* OP_LOADBOOL */
+  1,  /* OP_LOADNIL */
+  1,  /* OP_GETUPVAL */
+  2,  /* OP_GETTABUP */
+  2,  /* OP_GETTABLE */
+  2,  /* OP_SETTABUP */
+  1,  /* OP_SETUPVAL */
+  2,  /* OP_SETTABLE */
+  4,  /* OP_NEWTABLE */
+  2,  /* OP_SELF */
+  1,  /* OP_ADD */
+  1,  /* OP_SUB */
+  1,  /* OP_MUL */
+  2,  /* OP_DIV */
+  2,  /* OP_MOD */
+  4,  /* OP_POW */
+  2,  /* OP_IDIV */
+  1,  /* OP_BAND */
+  1,  /* OP_BOR */
+  1,  /* OP_BXOR */
+  1,  /* OP_SHL */
+  1,  /* OP_SHR */
+  1,  /* OP_LSHR */
+  1,  /* OP_ROTL */
+  1,  /* OP_ROTR */
+  1,  /* OP_UNM */
+  1,  /* OP_BNOT */
+  1,  /* OP_NOT */
+  1,  /* OP_PEEK */
+  1,  /* OP_PEEK2 */
+  1,  /* OP_PEEK4 */
+  1,  /* OP_LEN */
+  4,  /* OP_CONCAT */
+  1,  /* OP_JMP */
+  1,  /* OP_EQ */
+  1,  /* OP_LT */
+  1,  /* OP_LE */
+  1,  /* OP_TEST */
+  1,  /* OP_TESTSET */
+  4,  /* OP_CALL */
+  4,  /* OP_TAILCALL */
+  2,  /* OP_RETURN */
+  1,  /* OP_FORLOOP */
+  2,  /* OP_FORPREP */
+  4,  /* OP_TFORCALL */
+  1,  /* OP_TFORLOOP */
+  2,  /* OP_SETLIST */
+  4,  /* OP_CLOSURE */
+  2,  /* OP_VARARG */
+  0   /* OP_EXTRAARG */
+};
+
+static_assert(sizeof(opcost) / sizeof(opcost[0]) == NUM_OPCODES,
+              "opcost needs one entry per opcode, ending with OP_EXTRAARG");
+
 #define vmdispatch(o)	switch(o)
 #define vmcase(l,b)	case l: {b}  break;
 #define vmcasenb(l,b)	case l: {b}		/* nb = no break */
@@ -593,6 +659,7 @@ void luaV_execute (lua_State *L) {
         (--L->hookcount == 0 || L->hookmask & LUA_MASKLINE)) {
       Protect(traceexec(L));
     }
+    G(L)->cpucycles += opcost[GET_OPCODE(i)];
     /* WARNING: several calls may realloc the stack and invalidate `ra' */
     ra = RA(i);
     lua_assert(base == ci->u.l.base);
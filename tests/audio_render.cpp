@@ -0,0 +1,416 @@
+// audio_render.cpp
+// Headless audio renderer: WAV export, synth throughput and golden PCM hashes
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <time.h>
+#include <unistd.h>
+#include <libgen.h>
+#include <linux/limits.h>
+
+extern "C" {
+#include "pico_vm.h"
+#include "pico_audio.h"
+}
+
+#define RENDER_BLOCK 1024
+#define MAX_SECONDS 60          // Cap for looping sfx/music when writing WAVs
+#define TEST_SECONDS 10         // Rendered per music/sfx in --test
+#define BENCH_SECONDS 20        // Rendered per waveform/effect pair in --bench
+#define BASELINE_FILE "tests/baselines/audio_hashes.txt"
+
+static char base_path[PATH_MAX];
+
+// Joins a path under the repo root; false when it doesn't fit out
+static bool resolve_path(const char* rel_path, char* out_path, size_t out_size) {
+    int n = snprintf(out_path, out_size, "%s/%s", base_path, rel_path);
+    return n > 0 && (size_t)n < out_size;
+}
+
+static const char* test_carts[] = {
+    "songtest.p8",
+    "Celeste.p8.png",
+    "kaido.p8.png",
+    "lander.p8.png",
+    "racer.p8",
+    "ld45.p8",
+};
+
+static const char* wave_names[8] = {
+    "triangle", "tilted", "sawtooth", "square", "pulse", "organ", "noise", "phaser",
+};
+
+static const char* effect_names[8] = {
+    "none", "slide", "vibrato", "drop", "fade_in", "fade_out", "arp_fast", "arp_slow",
+};
+
+// Rendering
+
+typedef enum {
+    RENDER_SFX,
+    RENDER_MUSIC,
+} RenderKind;
+
+static bool playing(const pico_audio_t* audio, RenderKind kind) {
+    if (kind == RENDER_MUSIC) return audio->music.pattern_index >= 0;
+    for (int c = 0; c < PICO_CHANNELS; c++) {
+        if (audio->channels[c].sfx_index >= 0) return true;
+    }
+    return false;
+}
+
+// Renders until playback stops or max_samples; returns samples written
+static uint32_t render(pico_vm_t* vm, RenderKind kind, int n, int16_t* out, uint32_t max_samples) {
+    pico_audio_reset(&vm->audio);
+    if (kind == RENDER_MUSIC) {
+        pico_music(&vm->audio, n, 0, 0);
+    } else {
+        pico_sfx(&vm->audio, n, 0, 0, PICO_NOTES_PER_SFX);
+    }
+
+    uint32_t done = 0;
+    while (done < max_samples && playing(&vm->audio, kind)) {
+        uint32_t len = max_samples - done;
+        if (len > RENDER_BLOCK) len = RENDER_BLOCK;
+        pico_audio_fill(&vm->audio, out + done, (uint16_t)len);
+        done += len;
+    }
+    return done;
+}
+
+static uint32_t pcm_hash(const int16_t* pcm, uint32_t n) {
+    uint32_t h = 2166136261u;
+    for (uint32_t i = 0; i < n; i++) {
+        h = (h ^ (uint8_t)(pcm[i] & 0xFF)) * 16777619u;
+        h = (h ^ (uint8_t)((uint16_t)pcm[i] >> 8)) * 16777619u;
+    }
+    return h;
+}
+
+static bool sfx_has_notes(const pico_sfx_t* sfx) {
+    for (int i = 0; i < PICO_NOTES_PER_SFX; i++) {
+        if (pico_note_volume(&sfx->notes[i]) > 0) return true;
+    }
+    return false;
+}
+
+static bool song_has_channels(const pico_song_t* song) {
+    for (int c = 0; c < PICO_CHANNELS; c++) {
+        if (!(song->data[c] & 0x40)) return true;
+    }
+    return false;
+}
+
+// WAV Output
+
+static void put_u32(FILE* f, uint32_t v) {
+    uint8_t b[4] = {(uint8_t)v, (uint8_t)(v >> 8), (uint8_t)(v >> 16), (uint8_t)(v >> 24)};
+    fwrite(b, 1, 4, f);
+}
+
+static void put_u16(FILE* f, uint16_t v) {
+    uint8_t b[2] = {(uint8_t)v, (uint8_t)(v >> 8)};
+    fwrite(b, 1, 2, f);
+}
+
+static bool write_wav(const char* path, const int16_t* pcm, uint32_t n) {
+    FILE* f = fopen(path, "wb");
+    if (!f) return false;
+    fwrite("RIFF", 1, 4, f);
+    put_u32(f, 36 + n * 2);
+    fwrite("WAVEfmt ", 1, 8, f);
+    put_u32(f, 16);
+    put_u16(f, 1);                      // PCM
+    put_u16(f, 1);                      // Mono
+    put_u32(f, PICO_SAMPLE_RATE);
+    put_u32(f, PICO_SAMPLE_RATE * 2);
+    put_u16(f, 2);
+    put_u16(f, 16);
+    fwrite("data", 1, 4, f);
+    put_u32(f, n * 2);
+    for (uint32_t i = 0; i < n; i++) put_u16(f, (uint16_t)pcm[i]);
+    return fclose(f) == 0;
+}
+
+// Modes
+
+static bool load(pico_vm_t* vm, const char* path) {
+    if (!pico_vm_init(vm)) {
+        printf("Failed to init VM: %s\n", pico_vm_get_error(vm));
+        return false;
+    }
+    if (!pico_vm_load_cart(vm, path)) {
+        printf("Failed to load %s: %s\n", path, pico_vm_get_error(vm));
+        pico_vm_shutdown(vm);
+        return false;
+    }
+    return true;
+}
+
+static int run_export(const char* cart, RenderKind kind, int n, const char* out_path) {
+    static pico_vm_t vm;
+    if (!load(&vm, cart)) return 1;
+
+    uint32_t max = MAX_SECONDS * PICO_SAMPLE_RATE;
+    int16_t* pcm = (int16_t*)malloc(max * sizeof(int16_t));
+    uint32_t len = render(&vm, kind, n, pcm, max);
+    pico_vm_shutdown(&vm);
+
+    char default_path[64];
+    if (!out_path) {
+        snprintf(default_path, sizeof(default_path), "%s%d.wav",
+                 kind == RENDER_MUSIC ? "music" : "sfx", n);
+        out_path = default_path;
+    }
+    bool ok = write_wav(out_path, pcm, len);
+    printf("%s: %u samples (%.2fs), hash %08x\n", ok ? out_path : "write failed",
+           len, (double)len / PICO_SAMPLE_RATE, pcm_hash(pcm, len));
+    free(pcm);
+    return ok ? 0 : 1;
+}
+
+static double now_seconds() {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+// All four channels play a looping sfx of one waveform and effect
+static int run_bench(int seconds) {
+    static pico_vm_t vm;
+    if (!pico_vm_init(&vm)) return 1;
+
+    static int16_t block[RENDER_BLOCK];
+    uint32_t total = seconds * PICO_SAMPLE_RATE;
+    printf("Mixed output, Msamples/s (realtime is %.4f), 4 channels, %ds per pair\n\n",
+           PICO_SAMPLE_RATE / 1e6, seconds);
+    printf("%-10s", "");
+    for (int fx = 0; fx < 8; fx++) printf(" %9s", effect_names[fx]);
+    printf("\n");
+
+    for (int w = 0; w < 8; w++) {
+        printf("%-10s", wave_names[w]);
+        for (int fx = 0; fx < 8; fx++) {
+            for (int c = 0; c < PICO_CHANNELS; c++) {
+                pico_sfx_t* sfx = &vm.ram.sfx[c];
+                memset(sfx, 0, sizeof(pico_sfx_t));
+                sfx->speed = 8;
+                sfx->loop_end = PICO_NOTES_PER_SFX;
+                for (int i = 0; i < PICO_NOTES_PER_SFX; i++) {
+                    pico_note_set_key(&sfx->notes[i], 12 + (i * 7 + c * 5) % 40);
+                    pico_note_set_waveform(&sfx->notes[i], w);
+                    pico_note_set_volume(&sfx->notes[i], 5);
+                    pico_note_set_effect(&sfx->notes[i], fx);
+                }
+            }
+            pico_audio_reset(&vm.audio);
+            for (int c = 0; c < PICO_CHANNELS; c++) {
+                pico_sfx(&vm.audio, c, c, 0, PICO_NOTES_PER_SFX);
+            }
+
+            double t0 = now_seconds();
+            for (uint32_t done = 0; done < total; done += RENDER_BLOCK) {
+                pico_audio_fill(&vm.audio, block, RENDER_BLOCK);
+            }
+            double rate = total / (now_seconds() - t0);
+            printf(" %9.2f", rate / 1e6);
+        }
+        printf("\n");
+    }
+    pico_vm_shutdown(&vm);
+    return 0;
+}
+
+// Golden hashes, one line per render: "<cart>:<music|sfx><n> <hash>"
+static bool load_baseline(const char* key, uint32_t* hash) {
+    char path[PATH_MAX];
+    if (!resolve_path(BASELINE_FILE, path, sizeof(path))) return false;
+    FILE* f = fopen(path, "r");
+    if (!f) return false;
+
+    char line_key[160];
+    unsigned int h;
+    bool found = false;
+    while (fscanf(f, "%159s %8x", line_key, &h) == 2) {
+        if (strcmp(line_key, key) == 0) {
+            *hash = h;
+            found = true;
+            break;
+        }
+    }
+    fclose(f);
+    return found;
+}
+
+// Music fades: the gain must track the ramp for the whole fade, including
+// fades longer than 65536 samples, and a fade out must end playback on time
+static bool fade_tracks(pico_vm_t* vm, int n, uint16_t ms) {
+    const int32_t one = 1 << 16;
+    uint32_t total = (uint32_t)ms * PICO_SAMPLE_RATE / 1000;
+    int16_t block[RENDER_BLOCK];
+    pico_audio_t* audio = &vm->audio;
+
+    pico_audio_reset(audio);
+    pico_music(audio, n, ms, 0);
+    int32_t peak = 0;
+    for (uint32_t done = 0; done < total; ) {
+        uint32_t len = total - done < RENDER_BLOCK ? total - done : RENDER_BLOCK;
+        pico_audio_fill(audio, block, (uint16_t)len);
+        done += len;
+        if (done <= total / 2) {
+            for (uint32_t i = 0; i < len; i++) peak = abs(block[i]) > peak ? abs(block[i]) : peak;
+        }
+        int32_t expect = (int32_t)((int64_t)one * done / total);
+        if (abs(audio->music.gain - expect) > one / 256) {
+            printf("FAIL: fade in %ums, gain %d at sample %u, expected %d\n",
+                   (unsigned)ms, (int)audio->music.gain, (unsigned)done, (int)expect);
+            return false;
+        }
+    }
+    if (peak == 0) {
+        printf("FAIL: fade in %ums silent for its first half\n", (unsigned)ms);
+        return false;
+    }
+
+    pico_music(audio, -1, ms, 0);
+    uint32_t done = 0;
+    while (audio->music.pattern_index >= 0 && done <= total) {
+        pico_audio_fill(audio, block, RENDER_BLOCK);
+        done += RENDER_BLOCK;
+        int32_t expect = done < total ? (int32_t)((int64_t)one * (total - done) / total) : 0;
+        if (audio->music.pattern_index >= 0 && abs(audio->music.gain - expect) > one / 256) {
+            printf("FAIL: fade out %ums, gain %d at sample %u, expected %d\n",
+                   (unsigned)ms, (int)audio->music.gain, (unsigned)done, (int)expect);
+            return false;
+        }
+    }
+    if (audio->music.pattern_index >= 0 || done < total) {
+        printf("FAIL: fade out %ums ended after %u samples, expected %u\n",
+               (unsigned)ms, (unsigned)done, (unsigned)total);
+        return false;
+    }
+    return true;
+}
+
+static int run_test(bool record) {
+    int passed = 0, failed = 0;
+    FILE* out = NULL;
+    if (record) {
+        char path[PATH_MAX];
+        out = resolve_path(BASELINE_FILE, path, sizeof(path)) ? fopen(path, "w") : NULL;
+        if (!out) {
+            printf("Failed to write %s\n", BASELINE_FILE);
+            return 1;
+        }
+    }
+
+    uint32_t max = TEST_SECONDS * PICO_SAMPLE_RATE;
+    int16_t* pcm = (int16_t*)malloc(max * sizeof(int16_t));
+
+    for (size_t i = 0; i < sizeof(test_carts) / sizeof(test_carts[0]); i++) {
+        char rel[64], path[PATH_MAX];
+        snprintf(rel, sizeof(rel), "carts/%s", test_carts[i]);
+        static pico_vm_t vm;
+        if (!resolve_path(rel, path, sizeof(path)) || !load(&vm, path)) {
+            failed++;
+            continue;
+        }
+
+        for (int kind = RENDER_MUSIC; kind >= RENDER_SFX; kind--) {
+            for (int n = 0; n < PICO_SFX_COUNT; n++) {
+                if (kind == RENDER_MUSIC ? !song_has_channels(&vm.ram.songs[n])
+                                         : !sfx_has_notes(&vm.ram.sfx[n])) continue;
+                uint32_t len = render(&vm, (RenderKind)kind, n, pcm, max);
+                uint32_t hash = pcm_hash(pcm, len);
+                char key[160];
+                snprintf(key, sizeof(key), "%s:%s%d", test_carts[i],
+                         kind == RENDER_MUSIC ? "music" : "sfx", n);
+
+                if (record) {
+                    fprintf(out, "%s %08x\n", key, hash);
+                    passed++;
+                } else {
+                    uint32_t base;
+                    if (!load_baseline(key, &base)) {
+                        printf("NEW:  %s %08x\n", key, hash);
+                        passed++;
+                    } else if (base != hash) {
+                        printf("FAIL: %s hash %08x, baseline %08x\n", key, hash, base);
+                        failed++;
+                    } else {
+                        passed++;
+                    }
+                }
+                // One music render per cart, from the first used pattern
+                if (kind == RENDER_MUSIC) break;
+            }
+        }
+        pico_vm_shutdown(&vm);
+    }
+    free(pcm);
+
+    // Fades longer and shorter than 65536 samples (~2.97s)
+    static const uint16_t fade_ms[] = { 500, 3000, 6000 };
+    char rel[64], path[PATH_MAX];
+    snprintf(rel, sizeof(rel), "carts/%s", test_carts[0]);
+    static pico_vm_t vm;
+    if (resolve_path(rel, path, sizeof(path)) && load(&vm, path)) {
+        int n = 0;
+        while (n < PICO_MUSIC_COUNT && !song_has_channels(&vm.ram.songs[n])) n++;
+        for (size_t i = 0; i < sizeof(fade_ms) / sizeof(fade_ms[0]); i++) {
+            if (fade_tracks(&vm, n, fade_ms[i])) passed++; else failed++;
+        }
+        pico_vm_shutdown(&vm);
+    } else {
+        failed++;
+    }
+
+    if (out) {
+        fclose(out);
+        printf("Recorded audio hashes to %s\n", BASELINE_FILE);
+    }
+    printf("Results: %d passed, %d failed\n", passed, failed);
+    return failed > 0 ? 1 : 0;
+}
+
+static void usage() {
+    printf("Usage:\n"
+           "  audio_render <cart> sfx <n> [out.wav]\n"
+           "  audio_render <cart> music <n> [out.wav]\n"
+           "  audio_render --bench [seconds]\n"
+           "  audio_render --test [--record]\n");
+}
+
+int main(int argc, char** argv) {
+    char exe_path[PATH_MAX];
+    if (argv[0] && realpath(argv[0], exe_path)) {
+        // <root>/tests/build/audio_render -> <root>
+        strcpy(base_path, dirname(dirname(dirname(exe_path))));
+    } else {
+        getcwd(base_path, sizeof(base_path));
+    }
+
+    if (argc >= 2 && strcmp(argv[1], "--bench") == 0) {
+        return run_bench(argc >= 3 ? atoi(argv[2]) : BENCH_SECONDS);
+    }
+    if (argc >= 2 && strcmp(argv[1], "--test") == 0) {
+        return run_test(argc >= 3 && strcmp(argv[2], "--record") == 0);
+    }
+    if (argc >= 4) {
+        RenderKind kind;
+        if (strcmp(argv[2], "sfx") == 0) {
+            kind = RENDER_SFX;
+        } else if (strcmp(argv[2], "music") == 0) {
+            kind = RENDER_MUSIC;
+        } else {
+            usage();
+            return 1;
+        }
+        return run_export(argv[1], kind, atoi(argv[3]), argc >= 5 ? argv[4] : NULL);
+    }
+    usage();
+    return 1;
+}
@@ -11,10 +11,13 @@ extern "C" {
 #include "pico_vm.h"
 #include "pico_ram.h"
 #include "pico_cart.h"
+#include "pico_lua_api.h"
 }
 
 #define MAX_CARTS 100
 #define MAX_FRAMES 100
+#define TEST_RNG_SEED 1
+#define BASELINE_FILE "tests/baselines/frame_hashes.txt"
 
 static char base_path[PATH_MAX];
 
@@ -61,6 +64,7 @@ static CartTest all_carts[] = {
     {"per_char_width_test", "carts/per_char_width_test.p8", false},
     {"ppwr-big-digit-test", "carts/ppwr-big-digit-test.p8", false},
     {"print_mem_poke", "carts/print_mem_poke.p8", false},
+    {"print_poke_drawstate", "carts/print_poke_drawstate.p8", false},
     {"print_scroll_test", "carts/print_scroll_test.p8", false},
     {"pset00-test", "carts/pset00-test.p8", false},
     {"pset3pix", "carts/pset3pix.p8", false},
@@ -96,13 +100,68 @@ static int passed = 0;
 static int failed = 0;
 static int skipped = 0;
 
-bool run_cart_test(const char* name, const char* path, int max_frames) {
+// Per-frame screen hashes, one line per cart: "<name> <count> <hash>..."
+typedef struct {
+    uint32_t* hashes;
+    int count;
+} FrameHashes;
+
+static FrameHashes recorded[sizeof(all_carts) / sizeof(all_carts[0])];
+
+static bool load_baseline(const char* name, FrameHashes* out) {
+    char path[PATH_MAX];
+    resolve_cart_path(BASELINE_FILE, path, sizeof(path));
+    FILE* f = fopen(path, "r");
+    if (!f) return false;
+    
+    char cart[128];
+    int count;
+    bool found = false;
+    while (fscanf(f, "%127s %d", cart, &count) == 2) {
+        if (strcmp(cart, name) == 0 && count >= 0) {
+            out->hashes = (uint32_t*)malloc(sizeof(uint32_t) * (count > 0 ? count : 1));
+            out->count = 0;
+            while (out->count < count && fscanf(f, "%8x", &out->hashes[out->count]) == 1) {
+                out->count++;
+            }
+            found = true;
+            break;
+        }
+        int c;
+        while ((c = fgetc(f)) != EOF && c != '\n') {}
+    }
+    fclose(f);
+    return found;
+}
+
+static bool save_baselines(int num_carts) {
+    char path[PATH_MAX];
+    resolve_cart_path(BASELINE_FILE, path, sizeof(path));
+    FILE* f = fopen(path, "w");
+    if (!f) return false;
+    for (int i = 0; i < num_carts; i++) {
+        if (all_carts[i].skip) continue;
+        fprintf(f, "%s %d", all_carts[i].name, recorded[i].count);
+        for (int j = 0; j < recorded[i].count; j++) {
+            fprintf(f, " %08x", recorded[i].hashes[j]);
+        }
+        fprintf(f, "\n");
+    }
+    fclose(f);
+    return true;
+}
+
+bool run_cart_test(const char* name, const char* path, int max_frames, FrameHashes* hashes) {
     pico_vm_t vm;
     
+    hashes->hashes = (uint32_t*)malloc(sizeof(uint32_t) * (max_frames > 0 ? max_frames : 1));
+    hashes->count = 0;
+    
     if (!pico_vm_init(&vm)) {
         printf("FAIL: %s - failed to init VM: %s\n", name, pico_vm_get_error(&vm));
         return false;
     }
+    pico_lua_seed(&vm, TEST_RNG_SEED);
     
     if (!pico_vm_load_cart(&vm, path)) {
         printf("FAIL: %s - failed to load cart: %s\n", name, pico_vm_get_error(&vm));
@@ -114,6 +173,9 @@ bool run_cart_test(const char* name, const char* path, int max_frames) {
     
     for (int i = 0; i < max_frames && vm.state == PICO_VM_RUNNING; i++) {
         pico_vm_step(&vm);
+        if (vm.state == PICO_VM_RUNNING) {
+            hashes->hashes[hashes->count++] = vm.frame_hash;
+        }
     }
     
     if (vm.state == PICO_VM_ERROR) {
@@ -127,6 +189,67 @@ bool run_cart_test(const char* name, const char* path, int max_frames) {
     return true;
 }
 
+// Compares against the stored baseline; carts without one always match
+static bool check_baseline(const char* name, const FrameHashes* hashes, int max_frames) {
+    FrameHashes base = {NULL, 0};
+    if (!load_baseline(name, &base)) return true;
+    
+    bool ok = true;
+    int n = base.count < hashes->count ? base.count : hashes->count;
+    for (int i = 0; i < n; i++) {
+        if (base.hashes[i] != hashes->hashes[i]) {
+            printf("FAIL: %s - frame %d hash %08x, baseline %08x\n",
+                   name, i, hashes->hashes[i], base.hashes[i]);
+            ok = false;
+            break;
+        }
+    }
+    if (ok && hashes->count < base.count && hashes->count < max_frames) {
+        printf("FAIL: %s - stopped after %d frames, baseline has %d\n",
+               name, hashes->count, base.count);
+        ok = false;
+    }
+    free(base.hashes);
+    return ok;
+}
+
+#ifdef PICO_TEST_DEVICE_HEAP
+// A cart that grows without bound must end in PICO_VM_ERROR with Lua's
+// out-of-memory message, and leave a VM that shuts down cleanly
+static bool check_heap_exhaustion() {
+    static const char cart[] =
+        "pico-8 cartridge // http://www.pico-8.com\n"
+        "version 41\n"
+        "__lua__\n"
+        "t={}\n"
+        "function _update()\n"
+        " for i=1,200 do add(t,{i,i,i}) end\n"
+        "end\n";
+    pico_vm_t vm;
+    if (!pico_vm_init(&vm)) {
+        printf("FAIL: heap_exhaustion - failed to init VM: %s\n", pico_vm_get_error(&vm));
+        return false;
+    }
+    if (!pico_vm_load_cart_mem(&vm, (const uint8_t*)cart, sizeof(cart) - 1)) {
+        printf("FAIL: heap_exhaustion - failed to load cart: %s\n", pico_vm_get_error(&vm));
+        pico_vm_shutdown(&vm);
+        return false;
+    }
+    pico_vm_run(&vm);
+    for (int i = 0; i < 10000 && vm.state == PICO_VM_RUNNING; i++) {
+        pico_vm_step(&vm);
+    }
+    bool ok = vm.state == PICO_VM_ERROR &&
+              strstr(pico_vm_get_error(&vm), "not enough memory") != NULL;
+    if (!ok) {
+        printf("FAIL: heap_exhaustion - state %d after %u frames: %s\n",
+               (int)vm.state, vm.frame_count, pico_vm_get_error(&vm));
+    }
+    pico_vm_shutdown(&vm);
+    return ok;
+}
+#endif
+
 static char full_cart_path[PATH_MAX];
 
 const char* get_cart_path(const char* rel_path) {
@@ -157,8 +280,13 @@ int main(int argc, char** argv) {
     
     printf("Base path: %s\n", base_path);
     
-    if (argc > 1) {
-        max_frames = atoi(argv[1]);
+    bool record = false;
+    for (int i = 1; i < argc; i++) {
+        if (strcmp(argv[i], "--record") == 0) {
+            record = true;
+        } else {
+            max_frames = atoi(argv[i]);
+        }
     }
     
     printf("Running Picotility Cart Tests\n");
@@ -177,7 +305,12 @@ int main(int argc, char** argv) {
         printf("Testing: %s ... ", cart->name);
         fflush(stdout);
         
-        if (run_cart_test(cart->name, get_cart_path(cart->path), max_frames)) {
+        FrameHashes* hashes = &recorded[i];
+        bool ok = run_cart_test(cart->name, get_cart_path(cart->path), max_frames, hashes);
+        if (ok && !record) {
+            ok = check_baseline(cart->name, hashes, max_frames);
+        }
+        if (ok) {
             printf("PASS\n");
             passed++;
         } else {
@@ -185,6 +318,29 @@ int main(int argc, char** argv) {
         }
     }
     
+#ifdef PICO_TEST_DEVICE_HEAP
+    printf("Testing: heap_exhaustion ... ");
+    fflush(stdout);
+    if (check_heap_exhaustion()) {
+        printf("PASS\n");
+        passed++;
+    } else {
+        failed++;
+    }
+#endif
+    
+    if (record) {
+        if (save_baselines(num_carts)) {
+            printf("\nRecorded frame hashes to %s\n", BASELINE_FILE);
+        } else {
+            printf("\nFailed to write %s\n", BASELINE_FILE);
+        }
+    }
+    
+    for (int i = 0; i < num_carts; i++) {
+        free(recorded[i].hashes);
+    }
+    
     printf("\n=============================\n");
     printf("Results: %d passed, %d failed, %d skipped\n", passed, failed, skipped);
     